@@ -1,16 +1,59 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "include/assembler/assembler.hpp"
+#include "include/assembler/incremental.hpp"
+#include "include/assembler/linker.hpp"
+#include "include/assembler/optimizer.hpp"
+#include "include/debug/debug_info.hpp"
+#include "include/utils/artifact_cache.hpp"
+#include "include/utils/batch.hpp"
+#include "include/utils/file_watcher.hpp"
+#include "include/utils/parse_count.hpp"
 
 constexpr auto VERSION = 0.1;
 
 void print_help() {
-  std::cout << "usage: ch8asm <input_file> [-o <output_file>] [--verbose] "
-               "[--help] [--version]\n";
+  std::cout << "usage: ch8asm <input_file>... [-o <output_file>] [-O] [-g] "
+               "[--watch] [--batch] [--out-dir <dir>] [--cache-dir <dir>] "
+               "[--cache-size <mb>] [--threads <n>] [--verbose] [--help] "
+               "[--version]\n";
   std::cout << "options:\n"
             << "  -o <file>       specify output file (default: out.ch8)\n"
+            << "  -O              thread jumps, drop dead code and redundant "
+               "loads, merge\n"
+            << "                  identical sprites (single input)\n"
+            << "  -g              write debug info for ch8emu to "
+               "<output_file>.dbg\n"
+            << "  --watch         reassemble whenever the input changes\n"
+            << "  --batch         assemble every input to a ROM of its own; "
+               "inputs may be\n"
+            << "                  globs, - reads a list of paths from stdin\n"
+            << "  --out-dir <dir> where --batch writes ROMs (default: next to "
+               "each input)\n"
+            << "  --cache-dir <dir>\n"
+            << "                  keep assembled modules and ROMs in <dir>, "
+               "only changed\n"
+            << "                  files are rebuilt (ROMs built with -g "
+               "are not kept)\n"
+            << "  --cache-size <mb>\n"
+            << "                  bound of the cache directory, least "
+               "recently used\n"
+            << "                  entries go first (default: 64)\n"
+            << "  --threads <n>   threads assembling modules or batch inputs "
+               "(default: 0,\n"
+            << "                  all cores)\n"
             << "  --verbose       enable verbose output\n"
             << "  --help          show this help message\n"
             << "  --version       show version info\n";
@@ -18,6 +61,220 @@ void print_help() {
 
 void print_version() { std::cout << "ch8asm version " << VERSION << "\n"; }
 
+// ch8emu loads `<output>.dbg` on its own, one from an earlier -g build would
+// describe a different ROM
+void remove_stale_debug_info(const std::string &output) {
+  std::error_code ec;
+  std::filesystem::remove(output + ".dbg", ec);
+}
+
+// ====== Watch mode ======
+int watch(const std::string &input_file, const std::string &output_file,
+          bool verbose) {
+  IncrementalAssembler assembler;
+  FileWatcher watcher(input_file);
+
+  std::cout << "watching " << input_file << " (ctrl+c to stop)\n";
+  remove_stale_debug_info(output_file);
+
+  while (true) {
+    if (!watcher.Changed()) {
+      watcher.Wait();
+      continue;
+    }
+
+    try {
+      const std::string source = ReadSource(input_file);
+
+      const auto start = std::chrono::steady_clock::now();
+      const auto stats = assembler.Update(source);
+      assembler.WriteToFile(output_file);
+      const auto elapsed =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - start);
+
+      std::cout << "assembled " << output_file << " ("
+                << assembler.GetBytes().size() << " bytes) in "
+                << elapsed.count() << "us";
+      if (verbose) {
+        std::cout << ": " << stats.lines_tokenized << " lines tokenized, "
+                  << stats.lines_encoded << " encoded"
+                  << (stats.full ? ", full" : "");
+      }
+      std::cout << std::endl;
+    } catch (const std::exception &e) {
+      std::cerr << "assembler error: " << e.what() << "\n";
+    }
+  }
+
+  return 0;
+}
+
+// ====== Builds ======
+// bump whenever the same sources assemble to different bytes
+constexpr auto CACHE_VERSION = "1";
+
+struct BuildOptions {
+  bool optimize = false;
+  bool debug_info = false;
+  LinkOptions link; // link.cache also holds whole ROMs
+};
+
+struct BuildResult {
+  size_t bytes = 0;
+  bool cached = false; // copied from the cache, nothing was assembled
+  Linker::Stats link;
+  Optimizer::Stats optimize;
+};
+
+// The key covers the flags and every input, path and content. Includes are
+// only known after assembling, so the `.deps` entry next to the ROM lists
+// every linked file with its content hash, and a hit checks them all.
+uint64_t rom_cache_key(const std::vector<std::string> &inputs,
+                       const BuildOptions &options) {
+  uint64_t key = ArtifactCache::Key(
+      {"ch8asm", std::to_string(VERSION), CACHE_VERSION,
+       options.optimize ? "-O" : ""});
+
+  for (const auto &input : inputs) {
+    const std::string path = std::filesystem::weakly_canonical(input).string();
+    const std::string source = ReadSource(input);
+    key = ArtifactCache::Key(
+        {std::string_view(reinterpret_cast<const char *>(&key), sizeof(key)),
+         path, source});
+  }
+  return key;
+}
+
+bool fetch_cached_rom(ArtifactCache &cache, uint64_t key,
+                      const std::string &output) {
+  const auto deps = cache.Map(key, ".deps");
+  if (!deps)
+    return false;
+
+  std::istringstream in(
+      std::string(reinterpret_cast<const char *>(deps->data()), deps->size()));
+  std::string line;
+  while (std::getline(in, line)) {
+    // "<16 hex digits> <path>"
+    if (line.size() < 18)
+      return false;
+    try {
+      const uint64_t hash = std::stoull(line.substr(0, 16), nullptr, 16);
+      if (ArtifactCache::Key({ReadSource(line.substr(17))}) != hash)
+        return false;
+    } catch (const std::exception &) {
+      return false;
+    }
+  }
+
+  return cache.CopyTo(key, ".ch8", output);
+}
+
+void store_cached_rom(ArtifactCache &cache, uint64_t key,
+                      const std::vector<std::string> &sources,
+                      const std::vector<uint8_t> &bytes) {
+  std::ostringstream deps;
+  for (const auto &source : sources) {
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+                  static_cast<unsigned long long>(
+                      ArtifactCache::Key({ReadSource(source)})));
+    deps << hash << " " << source << "\n";
+  }
+
+  // the ROM first, a `.deps` entry is what makes it a hit
+  cache.Store(key, ".ch8", bytes.data(), bytes.size());
+  const std::string list = deps.str();
+  cache.Store(key, ".deps", list.data(), list.size());
+}
+
+// assembles `inputs` into one ROM at `output`, throws on errors
+BuildResult build(const std::vector<std::string> &inputs,
+                  const std::string &output, const BuildOptions &options) {
+  BuildResult result;
+  if (!options.debug_info)
+    remove_stale_debug_info(output);
+
+  // debug info is not cached, it names the files of this checkout
+  ArtifactCache *cache = options.debug_info ? nullptr : options.link.cache;
+  uint64_t key = 0;
+  if (cache) {
+    key = rom_cache_key(inputs, options);
+    if (fetch_cached_rom(*cache, key, output)) {
+      result.bytes = std::filesystem::file_size(output);
+      result.cached = true;
+      return result;
+    }
+  }
+
+  if (options.optimize) {
+    Optimizer optimizer(ReadSource(inputs.front()));
+    optimizer.WriteToFile(output);
+    if (options.debug_info) {
+      WriteDebugInfo(output + ".dbg", optimizer.GetBytes(), inputs,
+                     optimizer.GetSourceLines(), optimizer.GetLabelTable());
+    }
+    if (cache)
+      store_cached_rom(*cache, key, inputs, optimizer.GetBytes());
+
+    result.bytes = optimizer.GetBytes().size();
+    result.optimize = optimizer.GetStats();
+    return result;
+  }
+
+  Linker linker(inputs, options.link);
+  linker.WriteToFile(output);
+  if (options.debug_info) {
+    WriteDebugInfo(output + ".dbg", linker.GetBytes(), linker.GetSourceFiles(),
+                   linker.GetSourceLines(), linker.GetLabelTable());
+  }
+  if (cache)
+    store_cached_rom(*cache, key, linker.GetSourceFiles(), linker.GetBytes());
+
+  result.bytes = linker.GetBytes().size();
+  result.link = linker.GetStats();
+  return result;
+}
+
+// ====== Batch mode ======
+int batch(const std::vector<std::string> &args, const std::string &out_dir,
+          const BuildOptions &options, bool verbose) {
+  const std::vector<std::string> inputs = ExpandInputs(args);
+  if (verbose) {
+    std::cout << "[verbose] assembling " << inputs.size() << " files on "
+              << (options.link.threads ? std::to_string(options.link.threads)
+                                       : std::string("all"))
+              << " threads\n";
+  }
+
+  const std::vector<std::string> outputs =
+      BatchOutputPaths(inputs, out_dir, ".ch8");
+  if (!out_dir.empty())
+    std::filesystem::create_directories(out_dir);
+
+  // every input is one job, so each build itself runs single threaded
+  BuildOptions job_options = options;
+  job_options.link.threads = 1;
+
+  std::atomic<size_t> cached{0};
+  const auto report = RunBatch(
+      inputs, options.link.threads, [&](const std::string &input) {
+        const std::string &output = outputs[&input - inputs.data()];
+        const BuildResult built = build({input}, output, job_options);
+        if (built.cached)
+          cached += 1;
+
+        return BatchJobResult{std::filesystem::file_size(input), built.bytes};
+      });
+
+  std::cout << "assembled ";
+  PrintBatchReport(std::cout, report);
+  if (verbose && options.link.cache)
+    std::cout << "[verbose] " << cached << " ROMs from cache\n";
+  return report.failed ? 1 : 0;
+}
+
 int main(int argc, char *argv[]) {
   if (argc < 2) {
     std::cerr << "error: no input file provided.\n";
@@ -25,9 +282,18 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  std::string input_file;
+  // several inputs are laid out one after another, as if one file
+  // included them all
+  std::vector<std::string> input_files;
   std::string output_file = "out.ch8";
   bool verbose = false;
+  bool watch_input = false;
+  bool batch_mode = false;
+  bool output_given = false;
+  std::string out_dir;
+  BuildOptions options;
+  std::string cache_dir;
+  uint64_t cache_size = ArtifactCache::DEFAULT_MAX_BYTES;
 
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
@@ -40,38 +306,138 @@ int main(int argc, char *argv[]) {
       return 0;
     } else if (arg == "--verbose") {
       verbose = true;
+    } else if (arg == "-O") {
+      options.optimize = true;
+    } else if (arg == "-g") {
+      options.debug_info = true;
+    } else if (arg == "--watch") {
+      watch_input = true;
+    } else if (arg == "--batch") {
+      batch_mode = true;
+    } else if (arg == "--out-dir") {
+      if (i + 1 < argc) {
+        out_dir = argv[++i];
+      } else {
+        std::cerr << "error: --out-dir requires an argument.\n";
+        return 1;
+      }
     } else if (arg == "-o") {
       if (i + 1 < argc) {
         output_file = argv[++i];
+        output_given = true;
       } else {
         std::cerr << "error: -o requires an argument.\n";
         return 1;
       }
-    } else if (input_file.empty()) {
-      input_file = arg;
+    } else if (arg == "--cache-dir") {
+      if (i + 1 < argc) {
+        cache_dir = argv[++i];
+      } else {
+        std::cerr << "error: --cache-dir requires an argument.\n";
+        return 1;
+      }
+    } else if (arg == "--threads") {
+      uint64_t threads = 0;
+      if (i + 1 >= argc) {
+        std::cerr << "error: --threads requires an argument.\n";
+        return 1;
+      } else if (ParseCount(argv[++i], MAX_THREAD_COUNT, threads)) {
+        options.link.threads = threads;
+      } else {
+        std::cerr << "error: --threads takes a count from 0 to "
+                  << MAX_THREAD_COUNT << ", got '" << argv[i] << "'.\n";
+        return 1;
+      }
+    } else if (arg == "--cache-size") {
+      uint64_t megabytes = 0;
+      if (i + 1 >= argc) {
+        std::cerr << "error: --cache-size requires an argument.\n";
+        return 1;
+      } else if (ParseCount(argv[++i], UINT64_MAX >> 20, megabytes) &&
+                 megabytes > 0) {
+        cache_size = megabytes << 20;
+      } else {
+        std::cerr << "error: --cache-size takes a positive size in MB, got '"
+                  << argv[i] << "'.\n";
+        return 1;
+      }
+    } else if (arg.empty() || arg[0] != '-' || arg == "-") {
+      input_files.push_back(arg);
     } else {
       std::cerr << "unknown argument: " << arg << "\n";
       return 1;
     }
   }
 
-  if (input_file.empty()) {
+  if (input_files.empty()) {
     std::cerr << "error: no input file specified.\n";
     return 1;
   }
 
+  std::unique_ptr<ArtifactCache> cache;
+  if (!cache_dir.empty()) {
+    cache = std::make_unique<ArtifactCache>(cache_dir, cache_size);
+    options.link.cache = cache.get();
+  }
+
+  if (batch_mode) {
+    if (watch_input || output_given) {
+      std::cerr << "error: --batch cannot be combined with --watch or -o, "
+                   "see --out-dir.\n";
+      return 1;
+    }
+
+    try {
+      return batch(input_files, out_dir, options, verbose);
+    } catch (const std::exception &e) {
+      std::cerr << "assembler error: " << e.what() << "\n";
+      return 1;
+    }
+  }
+
+  if (watch_input) {
+    if (input_files.size() != 1) {
+      std::cerr << "error: --watch takes exactly one input file.\n";
+      return 1;
+    }
+    if (options.optimize || options.debug_info) {
+      std::cerr << "error: -O and -g cannot be combined with --watch.\n";
+      return 1;
+    }
+    return watch(input_files.front(), output_file, verbose);
+  }
+
+  if (options.optimize && input_files.size() != 1) {
+    std::cerr << "error: -O takes exactly one input file.\n";
+    return 1;
+  }
+
   if (verbose) {
-    std::cout << "[verbose] assembling " << input_file << " to " << output_file
-              << "\n";
+    std::cout << "[verbose] assembling";
+    for (const auto &input_file : input_files)
+      std::cout << " " << input_file;
+    std::cout << " to " << output_file << "\n";
   }
 
   try {
-    Assembler assembler = Assembler::FromFile(input_file);
-    assembler.WriteToFile(output_file);
+    const BuildResult built = build(input_files, output_file, options);
 
     if (verbose) {
-      std::cout << "[verbose] wrote " << output_file << " ("
-                << assembler.GetBytes().size() << " bytes)\n";
+      if (built.cached) {
+        std::cout << "[verbose] sources unchanged, ROM copied from cache\n";
+      } else if (options.optimize) {
+        const auto &stats = built.optimize;
+        std::cout << "[verbose] optimized: " << stats.jumps_threaded
+                  << " jumps threaded, " << stats.instructions_removed
+                  << " instructions removed, " << stats.blocks_merged
+                  << " sprite blocks merged, " << stats.bytes_saved
+                  << " bytes saved\n";
+      } else {
+        std::cout << "[verbose] linked " << built.link.modules
+                  << " modules (" << built.link.cached << " from cache)\n";
+      }
+      std::cout << "[verbose] wrote " << output_file << " (" << built.bytes
+                << " bytes)\n";
     } else {
       std::cout << "assembled successfully to " << output_file << "\n";
     }
@@ -1,15 +1,45 @@
+#include <cstdint>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "include/disassembler/disassembler.hpp"
+#include "include/utils/artifact_cache.hpp"
+#include "include/utils/batch.hpp"
+#include "include/utils/mapped_file.hpp"
+#include "include/utils/parse_count.hpp"
 
 constexpr auto VERSION = 0.1;
 
 void print_help() {
-  std::cout << "usage: ch8dis <input_file> [--verbose] [--help] [--version]\n";
+  std::cout << "usage: ch8dis <input_file>... [--batch] [--out-dir <dir>] "
+               "[--threads <n>] [--cache-dir <dir>] [--cache-size <mb>] "
+               "[--flow] [--verbose] [--help] [--version]\n";
   std::cout << "options:\n"
+            << "  --batch         write a listing per input to <input>.dis; "
+               "inputs may be\n"
+            << "                  globs, - reads a list of paths from stdin\n"
+            << "  --out-dir <dir> where --batch writes listings (default: "
+               "next to each input)\n"
+            << "  --threads <n>   threads for --batch (default: 0, all "
+               "cores)\n"
+            << "  --cache-dir <dir>\n"
+            << "                  keep listings in <dir>, a ROM seen before "
+               "is not\n"
+            << "                  disassembled again\n"
+            << "  --cache-size <mb>\n"
+            << "                  bound of the cache directory, least "
+               "recently used\n"
+            << "                  entries go first (default: 64)\n"
+            << "  --flow          follow control flow from 0x200, list what it "
+               "does not\n"
+            << "                  reach as data, and write source ch8asm "
+               "reassembles\n"
             << "  --verbose       enable verbose disassembly\n"
             << "  --help          show this help message\n"
             << "  --version       show version info\n";
@@ -17,6 +47,87 @@ void print_help() {
 
 void print_version() { std::cout << "ch8dis nuts version " << VERSION << "\n"; }
 
+struct ListingOptions {
+  bool flow = false;
+  bool verbose = false;
+};
+
+void decode(const MappedFile &rom, const ListingOptions &options,
+            const Disassembler::Sink &sink) {
+  if (options.flow)
+    Disassembler::DecodeRomFollowingFlow(rom.data(), rom.size(),
+                                         options.verbose, sink);
+  else
+    Disassembler::DecodeRom(rom.data(), rom.size(), options.verbose, sink);
+}
+
+// streams the listing of rom straight into the file, returns its size
+uint64_t write_listing(const MappedFile &rom, const ListingOptions &options,
+                       const std::string &path) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open file for writing: " + path);
+  }
+
+  uint64_t written = 0;
+  decode(rom, options, [&](const char *text, size_t length) {
+    file.write(text, length);
+    written += length;
+  });
+  file.close();
+  if (!file) {
+    throw std::runtime_error("failed to write data to file: " + path);
+  }
+  return written;
+}
+
+// ====== Cache ======
+// bump whenever the same ROM disassembles to a different listing
+constexpr auto CACHE_VERSION = "1";
+
+uint64_t listing_key(const MappedFile &rom, const ListingOptions &options) {
+  return ArtifactCache::Key(
+      {"ch8dis", std::to_string(VERSION), CACHE_VERSION,
+       options.verbose ? "--verbose" : "", options.flow ? "--flow" : "",
+       std::string_view(reinterpret_cast<const char *>(rom.data()),
+                        rom.size())});
+}
+
+// ====== Batch mode ======
+int batch(const std::vector<std::string> &args, const std::string &out_dir,
+          size_t threads, ArtifactCache *cache,
+          const ListingOptions &options) {
+  const std::vector<std::string> inputs = ExpandInputs(args);
+  const std::vector<std::string> outputs =
+      BatchOutputPaths(inputs, out_dir, ".dis");
+  if (!out_dir.empty())
+    std::filesystem::create_directories(out_dir);
+
+  const auto report =
+      RunBatch(inputs, threads, [&](const std::string &input) {
+        const MappedFile rom(input);
+        const std::string &output_path = outputs[&input - inputs.data()];
+
+        const uint64_t key = cache ? listing_key(rom, options) : 0;
+        if (cache && cache->CopyTo(key, ".dis", output_path)) {
+          return BatchJobResult{rom.size(),
+                                std::filesystem::file_size(output_path)};
+        }
+
+        const uint64_t written = write_listing(rom, options, output_path);
+        if (cache) {
+          // from the page cache, the listing is never held in memory
+          const MappedFile listing(output_path);
+          cache->Store(key, ".dis", listing.data(), listing.size());
+        }
+        return BatchJobResult{rom.size(), written};
+      });
+
+  std::cout << "disassembled ";
+  PrintBatchReport(std::cout, report);
+  return report.failed ? 1 : 0;
+}
+
 int main(int argc, char *argv[]) {
   if (argc < 2) {
     std::cerr << "error: no input file provided.\n";
@@ -24,8 +135,13 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  std::string input_file;
-  bool verbose = false;
+  std::vector<std::string> input_files;
+  ListingOptions options;
+  bool batch_mode = false;
+  std::string out_dir;
+  size_t threads = 0;
+  std::string cache_dir;
+  uint64_t cache_size = ArtifactCache::DEFAULT_MAX_BYTES;
 
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
@@ -37,25 +153,97 @@ int main(int argc, char *argv[]) {
       print_version();
       return 0;
     } else if (arg == "--verbose") {
-      verbose = true;
-    } else if (input_file.empty()) {
-      input_file = arg;
+      options.verbose = true;
+    } else if (arg == "--flow") {
+      options.flow = true;
+    } else if (arg == "--batch") {
+      batch_mode = true;
+    } else if (arg == "--out-dir") {
+      if (i + 1 < argc) {
+        out_dir = argv[++i];
+      } else {
+        std::cerr << "error: --out-dir requires an argument.\n";
+        return 1;
+      }
+    } else if (arg == "--threads") {
+      uint64_t count = 0;
+      if (i + 1 >= argc) {
+        std::cerr << "error: --threads requires an argument.\n";
+        return 1;
+      } else if (ParseCount(argv[++i], MAX_THREAD_COUNT, count)) {
+        threads = count;
+      } else {
+        std::cerr << "error: --threads takes a count from 0 to "
+                  << MAX_THREAD_COUNT << ", got '" << argv[i] << "'.\n";
+        return 1;
+      }
+    } else if (arg == "--cache-dir") {
+      if (i + 1 < argc) {
+        cache_dir = argv[++i];
+      } else {
+        std::cerr << "error: --cache-dir requires an argument.\n";
+        return 1;
+      }
+    } else if (arg == "--cache-size") {
+      uint64_t megabytes = 0;
+      if (i + 1 >= argc) {
+        std::cerr << "error: --cache-size requires an argument.\n";
+        return 1;
+      } else if (ParseCount(argv[++i], UINT64_MAX >> 20, megabytes) &&
+                 megabytes > 0) {
+        cache_size = megabytes << 20;
+      } else {
+        std::cerr << "error: --cache-size takes a positive size in MB, got '"
+                  << argv[i] << "'.\n";
+        return 1;
+      }
+    } else if (arg.empty() || arg[0] != '-' || arg == "-") {
+      input_files.push_back(arg);
     } else {
       std::cerr << "unknown argument: " << arg << "\n";
       return 1;
     }
   }
 
+  std::unique_ptr<ArtifactCache> cache;
+  if (!cache_dir.empty())
+    cache = std::make_unique<ArtifactCache>(cache_dir, cache_size);
+
+  if (batch_mode) {
+    try {
+      return batch(input_files, out_dir, threads, cache.get(), options);
+    } catch (const std::exception &e) {
+      std::cerr << "disassembler error: " << e.what() << "\n";
+      return 1;
+    }
+  }
+
+  if (input_files.size() != 1) {
+    std::cerr << "error: expected one input file, see --batch.\n";
+    return 1;
+  }
+
   try {
-    std::ifstream file(input_file, std::ios::binary);
-    if (!file) {
-      throw std::runtime_error("failed to open input file: " + input_file);
+    const MappedFile rom(input_files.front());
+
+    const uint64_t key = cache ? listing_key(rom, options) : 0;
+    if (cache) {
+      if (const auto listing = cache->Map(key, ".dis")) {
+        std::cout.write(reinterpret_cast<const char *>(listing->data()),
+                        listing->size());
+        return 0;
+      }
     }
 
-    std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)), {});
-    Disassembler dis;
-    std::string output = dis.DecodeRomFromArray(rom, verbose);
-    std::cout << output;
+    // kept only to fill the cache, stdout cannot be read back
+    std::string listing;
+    decode(rom, options, [&](const char *text, size_t length) {
+      std::cout.write(text, length);
+      if (cache)
+        listing.append(text, length);
+    });
+    if (cache)
+      cache->Store(key, ".dis", listing.data(), listing.size());
 
   } catch (const std::exception &e) {
     std::cerr << "disassembler error: " << e.what() << "\n";
@@ -1,17 +1,33 @@
 #include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <climits>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include "./include/assets/font.hpp"
+#include "./include/audio/beeper.hpp"
 #include "./include/chip8.hpp"
+#include "./include/debug/debug_info.hpp"
 #include "./include/disassembler/disassembler.hpp"
+#include "./include/emulator/hot_reload.hpp"
+#include "./include/utils/parse_count.hpp"
+#include "./include/utils/thread_pool.hpp"
+#include "./include/video/frame_writer.hpp"
+#include "./include/video/recorder.hpp"
 
 #include "raylib.h"
 
@@ -56,6 +72,26 @@ enum class EmulatorModes { Normal, Debug };
 constexpr int WINDOW_WIDTH = 955;
 constexpr int WINDOW_HEIGHT = 500;
 
+// host key for each chip8 key
+constexpr int CHIP8_KEYMAP[16] = {
+    KEY_X,     // 0
+    KEY_ONE,   // 1
+    KEY_TWO,   // 2
+    KEY_THREE, // 3
+    KEY_Q,     // 4
+    KEY_W,     // 5
+    KEY_E,     // 6
+    KEY_A,     // 7
+    KEY_S,     // 8
+    KEY_D,     // 9
+    KEY_Z,     // A
+    KEY_C,     // B
+    KEY_FOUR,  // C
+    KEY_R,     // D
+    KEY_F,     // E
+    KEY_V      // F
+};
+
 struct EmulatorTheme {
   Color background;
   Color video_pixel;
@@ -218,14 +254,34 @@ constexpr EmulatorTheme themes[THEMES_COUNT] = {
     EmulatorThemes::PEACHY_BLUSH,  //
 };
 
+struct EmulatorOptions {
+  size_t record_seconds = 30; // gameplay recorder length, 0 disables it
+  size_t run_ahead = 0;       // frames to run ahead of the displayed one
+  bool idle = true;           // stop redrawing while nothing changes
+  size_t turbo = 4;           // fast-forward speed multiplier, 0 unthrottled
+  HotReloader *hot_reloader = nullptr; // watched .chasm source, null disables
+  const DebugInfo *debug_info = nullptr; // source lines for the debugger
+};
+
 class Emulator {
 public:
-  Emulator(Chip8 &cpu, EmulatorModes emulator_mode)
+  Emulator(Chip8 &cpu, EmulatorModes emulator_mode,
+           const EmulatorOptions &options = {})
       : cpu(cpu), mode(emulator_mode),
         disassembled_rom(
             Disassembler::DecodeRomFromArrayAsVector(cpu.rom, false)) {
     initialize_raylib();
     initialize_video_settings();
+    initialize_recorder(options.record_seconds);
+    run_ahead_frames = options.run_ahead;
+    idle_enabled = options.idle;
+    turbo_multiplier = options.turbo;
+    hot_reloader = options.hot_reloader;
+    debug_info = options.debug_info;
+
+    // idling blocks on input events, a save would go unnoticed
+    if (hot_reloader)
+      idle_enabled = false;
   }
 
   void Run() {
@@ -234,26 +290,59 @@ public:
 
     while (!WindowShouldClose()) {
 
+      const uint64_t frame_start_cycle = cpu.cycles;
+      const auto frame_start = Clock::now();
+      ui_changed = false;
+
+      hot_reload();
+
       handle_cpu_input();
       handle_ui_input();
 
+      const bool turbo = turbo_active();
+
       // ====== Cycles and Timers ======
-      if (!paused)
-        execute_cycles();
+      if (!paused) {
+        if (turbo)
+          execute_turbo_frames();
+        else
+          execute_frame(frame_start);
+      }
 
       // ====== Timer update at 60HZ ======
-      update_timers(last_timer_tick);
+      // (turbo ticks the timers once per emulated frame instead)
+      if (turbo)
+        last_timer_tick = Clock::now();
+      else
+        update_timers(last_timer_tick);
+
+      measure_speed(paused ? 0 : turbo ? turbo_frames : 1);
+
+      // ====== Run-ahead ======
+      if (!paused && !turbo)
+        run_ahead();
+      else
+        display_video = cpu.video;
 
       // ====== Rendering ======
-      render();
+      if (should_idle()) {
+        wait_for_events();
+      } else {
+        render();
+      }
 
       // ====== Sound ======
+      collect_sound_events(frame_start_cycle);
       handle_sound();
+
+      // ====== Recording ======
+      if (!paused)
+        record_frame();
     }
   }
 
   ~Emulator() {
-    UnloadSound(beep);
+    beeper.reset();
     UnloadFont(fontTTF);
     CloseWindow();
     CloseAudioDevice();
@@ -266,6 +355,11 @@ private:
 
   // Emulator state
   bool paused = false;
+  bool ui_changed = false; // set by any ui shortcut during the current frame
+  bool key_state[16] = {}; // host keyboard state as of the last poll
+  // cycle a tapped key is released at, 0 when it is not tapped
+  uint64_t tap_release[16] = {};
+  std::vector<int> key_presses; // since the ui last read them
   int cycles_per_frame = 15;
   bool showControlsOverlay = false;
   EmulatorModes mode = EmulatorModes::Debug;
@@ -282,7 +376,50 @@ private:
 
   // raylib resources
   Font fontTTF;
-  Sound beep;
+  std::unique_ptr<Beeper> beeper;
+
+  // sound timer transitions of the current frame, as sample offsets
+  std::vector<Recorder::AudioEvent> frame_sound_events;
+
+  // gameplay recorder (null when disabled)
+  std::unique_ptr<Recorder> recorder;
+  // F9 dump writing a copy of the recorder, waited for on exit
+  std::future<void> recording_dump;
+
+  // idle: once the machine state stops changing (paused, halted, spinning in
+  // Fx0A or a jump-to-self), block on input events instead of redrawing
+  static constexpr size_t IDLE_AFTER_FRAMES = 2;
+  bool idle_enabled = true;
+  bool waiting_for_events = false;
+  size_t unchanged_frames = 0;
+  Chip8::State idle_state = {};
+  // key queue as of the last frame. a paused core never drains it, so only
+  // a change counts as activity
+  size_t idle_key_events_head = 0;
+  size_t idle_key_events_count = 0;
+
+  // turbo: hold TAB to fast-forward, G toggles it on. runs many emulated
+  // frames per host frame and only draws the newest one
+  size_t turbo_multiplier = 4;
+  bool turbo_toggled = false;
+  size_t turbo_frames = 0; // emulated frames run in the current host frame
+
+  // achieved speed, emulated frames per second over 60
+  float speed = 1.0f;
+  size_t speed_frames = 0;
+  std::chrono::time_point<Clock> speed_window_start = Clock::now();
+
+  // hot reload: re-assembles and patches the running program on every save
+  HotReloader *hot_reloader = nullptr;
+
+  // ch8asm -g output; the disassembly is used where it has no line
+  const DebugInfo *debug_info = nullptr;
+
+  // run-ahead: the video shown is `run_ahead_frames` into the future
+  size_t run_ahead_frames = 0;
+  Chip8::State run_ahead_state;
+  uint8_t run_ahead_video[Chip8::VIDEO_WIDTH * Chip8::VIDEO_HEIGHT] = {};
+  const uint8_t *display_video = cpu.video;
 
   // ====== Initializations ======
   void initialize_raylib() {
@@ -290,15 +427,25 @@ private:
     InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "ch8emu");
     SetTargetFPS(60);
 
-    // fontTTF = LoadFontEx("./fonts/Fredoka-Bold.ttf", 128, 0, 0);
-    fontTTF = LoadFontEx("./fonts/scp-bold.ttf", 128, 0, 0);
+    // prebuilt atlas of ./fonts/scp-bold.ttf at 128px, see tools/ch8fontgen
+    fontTTF = LoadEmbeddedFont();
 
     InitAudioDevice();
-    beep = LoadSound("./sounds/sine.wav");
+    beeper = std::make_unique<Beeper>();
 
     SetTextureFilter(fontTTF.texture, TEXTURE_FILTER_BILINEAR);
   }
 
+  void initialize_recorder(size_t seconds) {
+    frame_sound_events.reserve(Chip8::SOUND_EVENTS_CAPACITY);
+
+    if (seconds == 0)
+      return;
+
+    recorder = std::make_unique<Recorder>(cpu.VIDEO_WIDTH, cpu.VIDEO_HEIGHT,
+                                          seconds * Recorder::FPS);
+  }
+
   void initialize_video_settings() {
     if (mode == EmulatorModes::Normal) {
       VIDEO_SCREEN_WIDTH = WINDOW_WIDTH - 40;
@@ -317,60 +464,167 @@ private:
 
   // ====== Input Handling ======
   void handle_ui_input() {
-    if (IsKeyPressed(KEY_SPACE)) {
+    if (key_pressed(KEY_SPACE)) {
       showControlsOverlay = !showControlsOverlay;
+      ui_changed = true;
     }
 
     if (mode == EmulatorModes::Debug) {
-      if (IsKeyPressed(KEY_LEFT_BRACKET)) {
+      if (key_pressed(KEY_LEFT_BRACKET)) {
         cycles_per_frame -= 1;
         if (cycles_per_frame < 1)
           cycles_per_frame = 1;
-      } else if (IsKeyPressed(KEY_RIGHT_BRACKET)) {
+        ui_changed = true;
+      } else if (key_pressed(KEY_RIGHT_BRACKET)) {
         cycles_per_frame += 1;
-      } else if (IsKeyPressed(KEY_P)) {
+        ui_changed = true;
+      } else if (key_pressed(KEY_P)) {
         paused = !paused;
-      } else if (IsKeyPressed(KEY_N) && paused) {
+        ui_changed = true;
+      } else if (key_pressed(KEY_N) && paused) {
         execute_cycles();
+        ui_changed = true;
       }
     }
 
-    if (IsKeyPressed(KEY_T)) {
+    if (key_pressed(KEY_T)) {
       switch_theme();
+      ui_changed = true;
+    }
+
+    if (key_pressed(KEY_G)) {
+      turbo_toggled = !turbo_toggled;
+      ui_changed = true;
+    }
+
+    if (key_pressed(KEY_TAB) || IsKeyReleased(KEY_TAB)) {
+      ui_changed = true;
+    }
+
+    if (key_pressed(KEY_F9)) {
+      dump_recording();
     }
+
+    key_presses.clear();
+  }
+
+  // input is polled more than once a frame, a press the ui has not read yet
+  // may be gone from IsKeyPressed by now
+  bool key_pressed(int key) const {
+    return IsKeyPressed(key) ||
+           std::find(key_presses.begin(), key_presses.end(), key) !=
+               key_presses.end();
   }
 
   void handle_cpu_input() {
-    const int chip8_keymap[16] = {
-        KEY_X,     // 0
-        KEY_ONE,   // 1
-        KEY_TWO,   // 2
-        KEY_THREE, // 3
-        KEY_Q,     // 4
-        KEY_W,     // 5
-        KEY_E,     // 6
-        KEY_A,     // 7
-        KEY_S,     // 8
-        KEY_D,     // 9
-        KEY_Z,     // A
-        KEY_C,     // B
-        KEY_FOUR,  // C
-        KEY_R,     // D
-        KEY_F,     // E
-        KEY_V      // F
-    };
+    // every press since the last poll, including taps that were already
+    // released again (IsKeyDown alone would miss those)
+    bool pressed[16] = {};
+    for (int key = GetKeyPressed(); key != 0; key = GetKeyPressed()) {
+      key_presses.push_back(key);
+      for (int i = 0; i < 16; i++) {
+        if (CHIP8_KEYMAP[i] == key)
+          pressed[i] = true;
+      }
+    }
+
+    // transitions are stamped with the cycle they happened before, and the
+    // core applies them inside the execution loop. nothing is stamped ahead
+    // of now, so the queue stays in cycle order even while paused.
+    const uint64_t now = cpu.cycles;
 
     for (int i = 0; i < 16; i++) {
-      cpu.keypad[i] = IsKeyDown(chip8_keymap[i]) ? 1 : 0;
+      const bool down = IsKeyDown(CHIP8_KEYMAP[i]);
+
+      if (pressed[i] || (down && !key_state[i])) {
+        cpu.QueueKeyEvent(now, i, true);
+        tap_release[i] = 0;
+      }
+
+      // taps stay down for a full frame so polling loops get to see them
+      if (!down && pressed[i])
+        tap_release[i] = now + cycles_per_frame;
+      else if (!down && key_state[i])
+        cpu.QueueKeyEvent(now, i, false);
+
+      if (tap_release[i] != 0 && tap_release[i] <= now) {
+        cpu.QueueKeyEvent(now, i, false);
+        tap_release[i] = 0;
+      }
+
+      key_state[i] = down;
+    }
+  }
+
+  void collect_sound_events(uint64_t frame_start_cycle) {
+    frame_sound_events.clear();
+
+    // spread this frame's cycles over one frame worth of samples, so the
+    // buzzer toggles at the same relative point the timer changed
+    const uint64_t frame_cycles =
+        std::max<uint64_t>(cpu.cycles - frame_start_cycle, 1);
+
+    for (size_t i = 0; i < cpu.sound_events_count; i += 1) {
+      const Chip8::SoundEvent &event = cpu.sound_events[i];
+
+      uint64_t offset = 0;
+      if (event.cycle > frame_start_cycle)
+        offset = (event.cycle - frame_start_cycle) * Beeper::SAMPLES_PER_FRAME /
+                 frame_cycles;
+      offset = std::min<uint64_t>(offset, Beeper::SAMPLES_PER_FRAME - 1);
+
+      frame_sound_events.push_back({static_cast<uint16_t>(offset), event.on});
     }
+
+    cpu.ClearSoundEvents();
   }
 
   void handle_sound() {
-    if (cpu.sound > 0 && !IsSoundPlaying(beep)) {
-      PlaySound(beep);
+    beeper->BeginFrame();
+
+    for (const auto &event : frame_sound_events) {
+      beeper->Schedule(event.offset, event.on);
     }
   }
 
+  // ====== Recording ======
+  void record_frame() {
+    if (!recorder)
+      return;
+
+    recorder->Capture(cpu.video, frame_sound_events.data(),
+                      frame_sound_events.size());
+  }
+
+  void dump_recording() {
+    if (!recorder || recorder->Size() == 0)
+      return;
+
+    const auto stamp = std::chrono::duration_cast<std::chrono::seconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+    const std::string basename = "ch8emu-" + std::to_string(stamp);
+
+    // the y4m runs to hundreds of MB, writing it here would stall the window
+    if (recording_dump.valid() &&
+        recording_dump.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready) {
+      std::cerr << "still saving the last recording" << std::endl;
+      return;
+    }
+
+    recording_dump = std::async(
+        std::launch::async, [snapshot = *recorder, basename]() {
+          try {
+            const size_t frames = snapshot.Dump(basename);
+            std::cout << "recorded " << frames << " frames to " << basename
+                      << ".y4m/.wav" << std::endl;
+          } catch (const std::exception &e) {
+            std::cerr << "error: " << e.what() << std::endl;
+          }
+        });
+  }
+
   void switch_theme() {
     current_theme_index += 1;
     current_theme_index = current_theme_index % THEMES_COUNT;
@@ -378,12 +632,105 @@ private:
   }
 
   // ====== Execution ======
+  bool turbo_active() const { return turbo_toggled || IsKeyDown(KEY_TAB); }
+
+  // emulated frames carry their own timer tick, so timers keep pace with the
+  // speed-up. unthrottled runs as many as fit in most of a host frame.
+  void execute_turbo_frames() {
+    turbo_frames = 0;
+
+    if (turbo_multiplier > 0) {
+      for (size_t i = 0; i < turbo_multiplier; i += 1) {
+        cpu.RunFrame(cycles_per_frame);
+      }
+      turbo_frames = turbo_multiplier;
+      return;
+    }
+
+    const auto start = Clock::now();
+    const auto budget = std::chrono::milliseconds(12);
+    do {
+      cpu.RunFrame(cycles_per_frame);
+      turbo_frames += 1;
+    } while (Clock::now() - start < budget);
+  }
+
+  void measure_speed(size_t emulated_frames) {
+    speed_frames += emulated_frames;
+
+    const auto now = Clock::now();
+    const float elapsed =
+        std::chrono::duration<float>(now - speed_window_start).count();
+
+    if (elapsed >= 0.5f) {
+      speed = speed_frames / elapsed / 60.0f;
+      speed_frames = 0;
+      speed_window_start = now;
+    }
+  }
+
+  std::string speed_to_string() const {
+    std::ostringstream oss;
+    oss << "x" << std::fixed << std::setprecision(1) << speed;
+    return oss.str();
+  }
+
   void execute_cycles() {
     for (int i = 0; i < cycles_per_frame; i += 1) {
       cpu.Cycle();
     }
   }
 
+  // the frame's cycles run in slices spread over the first half of the host
+  // frame with input polled in between, so a key reaches the core within a
+  // few cycles of the press instead of at the next frame. the second half is
+  // left for rendering.
+  static constexpr int INPUT_SLICES = 4;
+
+  void execute_frame(std::chrono::time_point<Clock> frame_start) {
+    const auto slice_time =
+        std::chrono::microseconds(1000000 / 60) / 2 / INPUT_SLICES;
+
+    int executed = 0;
+    for (int slice = 1; slice <= INPUT_SLICES; slice += 1) {
+      for (; executed < cycles_per_frame * slice / INPUT_SLICES;
+           executed += 1) {
+        cpu.Cycle();
+      }
+      if (slice == INPUT_SLICES)
+        break;
+
+      std::this_thread::sleep_until(frame_start + slice * slice_time);
+      PollInputEvents();
+      handle_cpu_input();
+    }
+  }
+
+  // snapshot, emulate ahead with the current input, keep the future frame and
+  // rewind. the debug panels keep showing the real state.
+  void run_ahead() {
+    if (run_ahead_frames == 0) {
+      display_video = cpu.video;
+      return;
+    }
+
+    cpu.SaveState(run_ahead_state);
+
+    try {
+      for (size_t i = 0; i < run_ahead_frames; i += 1) {
+        cpu.RunFrame(cycles_per_frame);
+      }
+      std::copy(cpu.video, cpu.video + sizeof(run_ahead_video),
+                run_ahead_video);
+      display_video = run_ahead_video;
+    } catch (const std::exception &) {
+      // the real frames will hit (and report) it soon enough
+      display_video = cpu.video;
+    }
+
+    cpu.LoadState(run_ahead_state);
+  }
+
   void update_timers(std::chrono::time_point<Clock> &last_timer_tick) {
     auto now = Clock::now();
     auto elapsed = std::chrono::duration<float>(now - last_timer_tick);
@@ -393,6 +740,87 @@ private:
     }
   }
 
+  // ====== Hot reload ======
+  void hot_reload() {
+    if (!hot_reloader || !hot_reloader->SourceChanged())
+      return;
+
+    try {
+      const auto stats = hot_reloader->Reload(cpu);
+      disassembled_rom =
+          Disassembler::DecodeRomFromArrayAsVector(cpu.rom, false);
+      debug_info = nullptr; // describes the old layout
+      ui_changed = true;
+
+      std::cout << "reloaded " << hot_reloader->SourcePath() << ": "
+                << stats.bytes_patched << " bytes in " << stats.regions
+                << " regions" << (stats.remapped ? ", addresses remapped" : "")
+                << std::endl;
+    } catch (const std::exception &e) {
+      // keep running the last good build
+      std::cerr << "hot reload: " << e.what() << std::endl;
+    }
+  }
+
+  // ====== Idle ======
+  bool machine_state_changed() {
+    const Chip8::State &last = idle_state;
+
+    const bool same =
+        cpu.pc == last.pc && cpu.index == last.index && cpu.sp == last.sp &&
+        cpu.delay == last.delay && cpu.sound == last.sound &&
+        cpu.halted == last.halted && std::equal(cpu.V, cpu.V + 16, last.V) &&
+        std::equal(cpu.stack, cpu.stack + 16, last.stack) &&
+        std::equal(cpu.keypad, cpu.keypad + 16, last.keypad) &&
+        std::equal(cpu.video, cpu.video + sizeof(cpu.video), last.video) &&
+        std::equal(cpu.memory, cpu.memory + sizeof(cpu.memory), last.memory);
+
+    if (!same)
+      cpu.SaveState(idle_state);
+
+    return !same;
+  }
+
+  bool key_events_changed() {
+    // a full queue drops its oldest event, moving the head at equal count
+    const bool changed = cpu.key_events_head != idle_key_events_head ||
+                         cpu.key_events_count != idle_key_events_count;
+
+    idle_key_events_head = cpu.key_events_head;
+    idle_key_events_count = cpu.key_events_count;
+    return changed;
+  }
+
+  bool should_idle() {
+    if (!idle_enabled)
+      return false;
+
+    // a frame that left the state untouched will do so forever, until input
+    if (ui_changed || key_events_changed() || machine_state_changed())
+      unchanged_frames = 0;
+    else
+      unchanged_frames += 1;
+
+    const bool idle = unchanged_frames >= IDLE_AFTER_FRAMES;
+
+    if (!idle && waiting_for_events) {
+      DisableEventWaiting();
+      waiting_for_events = false;
+    }
+
+    return idle;
+  }
+
+  void wait_for_events() {
+    // the last drawn frame stays on screen, sleep until the next input event
+    if (!waiting_for_events) {
+      EnableEventWaiting();
+      waiting_for_events = true;
+    }
+
+    PollInputEvents();
+  }
+
   // ====== Rendering ======
   void render() {
     // ====== Mode-based rendering ======
@@ -472,6 +900,15 @@ private:
                {vox + hox, (float)VIDEO_SCREEN_HEIGHT + voy + hoy}, 14, 0,
                theme.disabled_text);
 
+    if (turbo_active()) {
+      const std::string turbo_str = "turbo " + speed_to_string();
+      const auto size = MeasureTextEx(fontTTF, turbo_str.c_str(), 14, 0);
+      DrawTextEx(fontTTF, turbo_str.c_str(),
+                 {vox + VIDEO_SCREEN_WIDTH - size.x,
+                  (float)VIDEO_SCREEN_HEIGHT + voy + hoy},
+                 14, 0, theme.text);
+    }
+
     // render shortcuts
     if (showControlsOverlay) {
       render_controls_overlay();
@@ -484,7 +921,7 @@ private:
     for (int row = 0; row < VIDEO_Y_COUNT; row += 1) {
       for (int col = 0; col < VIDEO_X_COUNT; col += 1) {
         const int index = row * VIDEO_X_COUNT + col;
-        const uint8_t pixel = cpu.video[index];
+        const uint8_t pixel = display_video[index];
 
         const int x = px + VIDEO_GRID_SIZE * col;
         const int y = py + VIDEO_GRID_SIZE * row;
@@ -624,6 +1061,15 @@ private:
   void render_disassembled_code_with_pc_opcode_and_instructions(float px,
                                                                 float py) {
     const int line_height = 30;
+
+    if (debug_info) {
+      const size_t current_line = debug_info->LineAt(cpu.pc);
+      if (current_line != DebugInfo::NO_LINE) {
+        render_source_lines(px, py, current_line);
+        return;
+      }
+    }
+
     const int current_index = (cpu.pc - 0x200) / 2;
 
     py += 5;
@@ -665,6 +1111,75 @@ private:
                              theme.border);
   }
 
+  // the source lines around the current one, from the debug info
+  void render_source_lines(float px, float py, size_t current_line) {
+    const int line_height = 30;
+    // what fits in the instruction column
+    const size_t max_text = 14;
+
+    py += 5;
+
+    const std::string header =
+        "LINE " + std::to_string(debug_info->GetLine(current_line).line);
+
+    DrawTextEx(fontTTF, "PC", {px + 10, py}, 20, 0, theme.disabled_text);
+
+    DrawTextEx(fontTTF, "OPCODE", {px + 70, py}, 20, 0, theme.disabled_text);
+
+    DrawTextEx(fontTTF, header.c_str(), {px + 140, py}, 20, 0,
+               theme.disabled_text);
+
+    py += line_height;
+
+    // Display one before, current, one after
+    for (int i = -1; i <= 1; ++i) {
+      const int index = (int)current_line + i;
+
+      if (index < 0 || index >= (int)debug_info->LineCount())
+        continue;
+
+      const DebugInfo::Line line = debug_info->GetLine(index);
+      const Color color = (i == 0) ? theme.current_instruction : theme.text;
+
+      const std::string address = hex_to_string(line.address, 3);
+
+      // whatever is in memory now, the program may have rewritten it
+      const uint16_t at = line.address & 0x0FFF;
+      const std::string opcode =
+          line.size == 1
+              ? hex_to_string(cpu.memory[at], 2)
+              : hex_to_string((cpu.memory[at] << 8u) |
+                                  cpu.memory[(at + 1) & 0x0FFF],
+                              4);
+
+      std::string_view source = line.text;
+      const size_t first = source.find_first_not_of(" \t");
+      source.remove_prefix(std::min(first, source.size()));
+
+      std::string text;
+      if (!line.label.empty() &&
+          source.substr(0, line.label.size()) != line.label) {
+        text.append(line.label.data(), line.label.size());
+        text += ": ";
+      }
+      text.append(source.data(), source.size());
+      if (text.size() > max_text)
+        text.resize(max_text);
+
+      DrawTextEx(fontTTF, address.c_str(),
+                 {px + 10, py + (i + 1) * line_height}, 20, 0, color);
+
+      DrawTextEx(fontTTF, opcode.c_str(), {px + 70, py + (i + 1) * line_height},
+                 20, 0, color);
+
+      DrawTextEx(fontTTF, text.c_str(), {px + 140, py + (i + 1) * line_height},
+                 20, 0, color);
+    }
+
+    DrawRectangleLinesBetter({px, py - (5 + line_height), (float)315, 130}, 1,
+                             theme.border);
+  }
+
   void render_debugger_params(float px, float py) {
 
     const int line_height = 30;
@@ -676,11 +1191,25 @@ private:
         "cycles per frame: " + std::to_string(cycles_per_frame);
     DrawTextEx(fontTTF, cycles_per_frame_str.c_str(), {px, py}, 20, 0,
                theme.text);
+
+    // achieved speed
+    py += line_height;
+    std::string speed_str = "speed: " + speed_to_string();
+    if (turbo_active())
+      speed_str += " (turbo)";
+    DrawTextEx(fontTTF, speed_str.c_str(), {px, py}, 20, 0, theme.text);
+
+    if (run_ahead_frames > 0) {
+      py += line_height;
+      std::string run_ahead_str =
+          "run-ahead: " + std::to_string(run_ahead_frames) + " frames";
+      DrawTextEx(fontTTF, run_ahead_str.c_str(), {px, py}, 20, 0, theme.text);
+    }
   }
 
   void render_controls_overlay() {
     float width = 300;
-    float height = 140;
+    float height = 200;
     float x = WINDOW_WIDTH - width;
     float y = WINDOW_HEIGHT - height;
     Rectangle rec = {x, y, width, height};
@@ -717,20 +1246,291 @@ private:
 
     DrawTextEx(fontTTF, "t : switch to next theme", {x, y}, 16, 0,
                theme.controls_overlay_text);
+    y += line_height;
+
+    DrawTextEx(fontTTF, "TAB : hold to fast-forward", {x, y}, 16, 0,
+               theme.controls_overlay_text);
+    y += line_height;
+    DrawTextEx(fontTTF, "g : toggle turbo", {x, y}, 16, 0,
+               theme.controls_overlay_text);
+    y += line_height;
+
+    if (recorder) {
+      DrawTextEx(fontTTF, "F9 : save recording (y4m + wav)", {x, y}, 16, 0,
+                 theme.controls_overlay_text);
+    }
 
     DrawRectangleLinesBetter(rec, 1, theme.border);
   }
 };
 
+// ====== Grid ======
+struct GridOptions {
+  size_t seeds = 0;   // > 0 runs a single ROM this many times, seeded 1..n
+  size_t threads = 0; // worker threads, 0 uses every core
+  int cycles_per_frame = 15;
+};
+
+// Runs one Chip8 per cell on a worker pool. Workers write their cell straight
+// into a shared pixel buffer, which is uploaded once and drawn with a single
+// textured quad per frame, however many instances there are.
+class GridEmulator {
+public:
+  GridEmulator(const std::vector<std::vector<uint8_t>> &roms,
+               const GridOptions &options)
+      : pool(options.threads), cycles_per_frame(options.cycles_per_frame) {
+
+    const size_t count = options.seeds > 0 ? options.seeds : roms.size();
+
+    for (size_t i = 0; i < count; i += 1) {
+      const auto &rom = roms[options.seeds > 0 ? 0 : i];
+
+      auto cpu = std::make_unique<Chip8>();
+      cpu->LoadFromArray(rom.data(), rom.size());
+      cpu->Seed(options.seeds > 0 ? i + 1 : cpu->rng_state + i);
+
+      instances.push_back(std::move(cpu));
+    }
+    crashed.assign(count, 0);
+
+    // as square as possible
+    columns = 1;
+    while (columns * columns < count)
+      columns += 1;
+    rows = (count + columns - 1) / columns;
+
+    atlas_width = columns * (Chip8::VIDEO_WIDTH + GAP) + GAP;
+    atlas_height = rows * (Chip8::VIDEO_HEIGHT + GAP) + GAP;
+    pixels.assign(atlas_width * atlas_height, theme.border);
+
+    initialize_raylib();
+  }
+
+  void Run() {
+    while (!WindowShouldClose()) {
+      handle_input();
+
+      // ====== Cycles, Timers and Compositing ======
+      pool.ParallelFor(instances.size(), [this](size_t i) { run_cell(i); });
+
+      // ====== Rendering ======
+      UpdateTexture(atlas, pixels.data());
+      render();
+    }
+  }
+
+  ~GridEmulator() {
+    UnloadTexture(atlas);
+    UnloadFont(fontTTF);
+    CloseWindow();
+  }
+
+private:
+  static constexpr size_t GAP = 1; // pixels between cells
+
+  std::vector<std::unique_ptr<Chip8>> instances;
+  std::vector<uint8_t> crashed; // written by workers, one byte per cell
+
+  ThreadPool pool;
+  int cycles_per_frame;
+
+  size_t columns = 1;
+  size_t rows = 1;
+  size_t atlas_width = 0;
+  size_t atlas_height = 0;
+  std::vector<Color> pixels;
+
+  size_t current_theme_index = 0;
+  EmulatorTheme theme = themes[current_theme_index];
+
+  // raylib resources
+  Texture2D atlas;
+  Font fontTTF;
+
+  void initialize_raylib() {
+    SetConfigFlags(FLAG_VSYNC_HINT | FLAG_WINDOW_HIGHDPI);
+    InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "ch8emu grid");
+    SetTargetFPS(60);
+
+    fontTTF = LoadEmbeddedFont();
+    SetTextureFilter(fontTTF.texture, TEXTURE_FILTER_BILINEAR);
+
+    Image image = GenImageColor(atlas_width, atlas_height, theme.border);
+    atlas = LoadTextureFromImage(image);
+    UnloadImage(image);
+    SetTextureFilter(atlas, TEXTURE_FILTER_POINT);
+  }
+
+  void handle_input() {
+    // every instance gets the same keypad
+    uint8_t keypad[16];
+    for (int i = 0; i < 16; i++) {
+      keypad[i] = IsKeyDown(CHIP8_KEYMAP[i]) ? 1 : 0;
+    }
+    for (auto &cpu : instances) {
+      std::copy(keypad, keypad + 16, cpu->keypad);
+    }
+
+    if (IsKeyPressed(KEY_T)) {
+      current_theme_index = (current_theme_index + 1) % THEMES_COUNT;
+      theme = themes[current_theme_index];
+      std::fill(pixels.begin(), pixels.end(), theme.border);
+    }
+  }
+
+  // runs on a worker thread, touches only cell `i`
+  void run_cell(size_t i) {
+    Chip8 &cpu = *instances[i];
+
+    if (!crashed[i]) {
+      try {
+        cpu.RunFrame(cycles_per_frame);
+        cpu.ClearSoundEvents();
+      } catch (const std::exception &) {
+        crashed[i] = 1;
+      }
+    }
+
+    const Color on = crashed[i] ? theme.disabled_text : theme.video_pixel;
+    const Color off = theme.background;
+
+    const size_t ox = (i % columns) * (Chip8::VIDEO_WIDTH + GAP) + GAP;
+    const size_t oy = (i / columns) * (Chip8::VIDEO_HEIGHT + GAP) + GAP;
+
+    for (size_t y = 0; y < Chip8::VIDEO_HEIGHT; y += 1) {
+      Color *row = &pixels[(oy + y) * atlas_width + ox];
+      const uint8_t *video = &cpu.video[y * Chip8::VIDEO_WIDTH];
+
+      for (size_t x = 0; x < Chip8::VIDEO_WIDTH; x += 1) {
+        row[x] = video[x] ? on : off;
+      }
+    }
+  }
+
+  void render() {
+    BeginDrawing();
+    ClearBackground(theme.background);
+
+    const float status_height = 30;
+
+    // fit the atlas into the window, keeping the aspect ratio
+    const float available_w = WINDOW_WIDTH - 20;
+    const float available_h = WINDOW_HEIGHT - 20 - status_height;
+    const float scale = std::min(available_w / atlas_width,
+                                 available_h / atlas_height);
+
+    const Rectangle src = {0, 0, (float)atlas_width, (float)atlas_height};
+    const Rectangle dst = {10, 10, atlas_width * scale, atlas_height * scale};
+    DrawTexturePro(atlas, src, dst, {0, 0}, 0, {255, 255, 255, 255});
+
+    const size_t crashed_count =
+        std::count(crashed.begin(), crashed.end(), uint8_t(1));
+
+    std::ostringstream status;
+    status << instances.size() << " instances, " << crashed_count
+           << " crashed, " << pool.ThreadCount() << " threads, " << GetFPS()
+           << " fps";
+    DrawTextEx(fontTTF, status.str().c_str(),
+               {10, WINDOW_HEIGHT - status_height + 5}, 16, 0, theme.text);
+
+    EndDrawing();
+  }
+};
+
+// ====== Headless ======
+struct HeadlessOptions {
+  FrameFormat format = FrameFormat::Raw;
+  std::string output = "-"; // "-" is stdout
+  size_t frames = 0;        // 0 runs until FxFF halts the ROM, if ever
+  unsigned int fps = 0;     // wall clock rate, 0 is unbounded
+  size_t scale = 1;
+  int cycles_per_frame = 15;
+};
+
+// Runs the core without raylib. One frame is 1/60s of emulated time (timers
+// tick once per frame), regardless of how fast frames are produced.
+void RunHeadless(Chip8 &cpu, const HeadlessOptions &options) {
+  std::ofstream file;
+  if (options.output != "-") {
+    file.open(options.output, std::ios::binary);
+    if (!file.is_open()) {
+      throw std::runtime_error("Failed to open output file: " + options.output);
+    }
+  } else {
+    std::ios::sync_with_stdio(false);
+  }
+  std::ostream &out = options.output == "-" ? std::cout : file;
+
+  FrameWriter writer(out, options.format, cpu.VIDEO_WIDTH, cpu.VIDEO_HEIGHT,
+                     60, options.scale);
+
+  const auto frame_duration =
+      options.fps ? std::chrono::nanoseconds(1'000'000'000 / options.fps)
+                  : std::chrono::nanoseconds(0);
+  auto next_frame = Clock::now();
+
+  for (size_t frame = 0; options.frames == 0 || frame < options.frames;
+       frame += 1) {
+    cpu.RunFrame(options.cycles_per_frame);
+    cpu.ClearSoundEvents();
+
+    writer.WriteFrame(cpu.video);
+
+    if (cpu.halted)
+      break;
+
+    if (options.fps) {
+      next_frame += frame_duration;
+      std::this_thread::sleep_until(next_frame);
+    }
+  }
+
+  out.flush();
+}
+
 // ====== CLI ======
 namespace CLI {
 void print_usage(const std::string &programName) {
   std::cout << "ch8emu Usage:\n";
-  std::cout << "  " << programName << " <rom_path> [options]\n\n";
+  std::cout << "  " << programName << " <rom_path> [options]\n";
+  std::cout << "  " << programName
+            << " --grid <rom_path>... [--seeds <n>] [--threads <n>]\n\n";
   std::cout << "options:\n";
   std::cout << "  -m, --mode <mode>    set emulator mode (debug or normal, "
                "default: debug)\n";
-  std::cout << "  -h, --help           show this help message\n";
+  std::cout << "  -r, --record <secs>  seconds of play kept for F9 "
+               "recording (default: 30, 0 disables)\n";
+  std::cout << "  --run-ahead <n>      display n frames ahead to hide input "
+               "latency (default: 0)\n";
+  std::cout << "  --no-idle            keep redrawing while nothing changes\n";
+  std::cout << "  --turbo <x>          fast-forward speed multiplier "
+               "(default: 4, 0 unthrottled)\n";
+  std::cout << "  --hot-reload         treat <rom_path> as a .chasm source, "
+               "patch the running\n"
+               "                       program each time it is saved\n";
+  std::cout << "  --debug-info <file>  source lines and labels from ch8asm -g "
+               "(default:\n"
+               "                       <rom_path>.dbg when it exists)\n";
+  std::cout << "  -h, --help           show this help message\n\n";
+  std::cout << "headless options:\n";
+  std::cout << "  --headless           run without a window, stream frames\n";
+  std::cout << "  --format <fmt>       frame format (raw, ppm or y4m, "
+               "default: raw)\n";
+  std::cout << "  -o, --output <file>  frame output file (default: - for "
+               "stdout)\n";
+  std::cout << "  --frames <n>         stop after n frames (default: 0, run "
+               "until FxFF halts\n"
+               "                       the ROM, forever if it never does)\n";
+  std::cout << "  --fps <n>            frames per second of wall time "
+               "(default: 0, unbounded)\n";
+  std::cout << "  --scale <n>          integer upscale for ppm/y4m "
+               "(1 to 64, default: 1)\n";
+  std::cout << "  --cycles <n>         cpu cycles per frame (default: 15)\n\n";
+  std::cout << "grid options:\n";
+  std::cout << "  --grid               run every given ROM side by side\n";
+  std::cout << "  --seeds <n>          run one ROM n times with seeds 1..n\n";
+  std::cout << "  --threads <n>        worker threads (default: 0, all "
+               "cores)\n";
 }
 
 EmulatorModes parse_mode(const std::string &modeStr) {
@@ -748,12 +1548,39 @@ EmulatorModes parse_mode(const std::string &modeStr) {
 } // namespace CLI
 
 int main(int argc, char *args[]) {
-  std::string romPath;
+  std::vector<std::string> romPaths;
   EmulatorModes mode = EmulatorModes::Debug; // Default mode
+  bool headless = false;
+  HeadlessOptions headless_options;
+  bool grid = false;
+  GridOptions grid_options;
+  EmulatorOptions emulator_options;
+  bool hot_reload = false;
+  std::string debug_info_path;
+
+  // returns the value following a flag, or exits with usage
+  auto next_arg = [&](int &i, const std::string &flag) -> std::string {
+    if (i + 1 >= argc) {
+      std::cerr << "Error: Missing argument for " << flag << "\n";
+      CLI::print_usage(args[0]);
+      std::exit(EXIT_FAILURE);
+    }
+    return args[++i];
+  };
+
+  // reports a flag value ParseCount turned down, for main to return
+  auto invalid_value = [&](const std::string &flag,
+                           const std::string &value) {
+    std::cerr << "Error: invalid value for " << flag << ": '" << value
+              << "'\n";
+    CLI::print_usage(args[0]);
+    return EXIT_FAILURE;
+  };
 
   // Parse command line arguments
   for (int i = 1; i < argc; ++i) {
     std::string arg = args[i];
+    uint64_t count = 0;
 
     if (arg == "-h" || arg == "--help") {
       CLI::print_usage(args[0]);
@@ -771,10 +1598,67 @@ int main(int argc, char *args[]) {
         CLI::print_usage(args[0]);
         return EXIT_FAILURE;
       }
+    } else if (arg == "-r" || arg == "--record") {
+      if (!ParseCount(next_arg(i, arg), 3600, count))
+        return invalid_value(arg, args[i]);
+      emulator_options.record_seconds = count;
+    } else if (arg == "--run-ahead") {
+      if (!ParseCount(next_arg(i, arg), 60, count))
+        return invalid_value(arg, args[i]);
+      emulator_options.run_ahead = count;
+    } else if (arg == "--turbo") {
+      if (!ParseCount(next_arg(i, arg), 1000, count))
+        return invalid_value(arg, args[i]);
+      emulator_options.turbo = count;
+    } else if (arg == "--no-idle") {
+      emulator_options.idle = false;
+    } else if (arg == "--hot-reload") {
+      hot_reload = true;
+    } else if (arg == "--debug-info") {
+      debug_info_path = next_arg(i, arg);
+    } else if (arg == "--headless") {
+      headless = true;
+    } else if (arg == "--format") {
+      try {
+        headless_options.format = ParseFrameFormat(next_arg(i, arg));
+      } catch (const std::invalid_argument &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        CLI::print_usage(args[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "-o" || arg == "--output") {
+      headless_options.output = next_arg(i, arg);
+    } else if (arg == "--frames") {
+      if (!ParseCount(next_arg(i, arg), SIZE_MAX, count))
+        return invalid_value(arg, args[i]);
+      headless_options.frames = count;
+    } else if (arg == "--fps") {
+      if (!ParseCount(next_arg(i, arg), UINT_MAX, count))
+        return invalid_value(arg, args[i]);
+      headless_options.fps = static_cast<unsigned int>(count);
+    } else if (arg == "--scale") {
+      if (!ParseCount(next_arg(i, arg), 64, count) || count == 0)
+        return invalid_value(arg, args[i]);
+      headless_options.scale = count;
+    } else if (arg == "--cycles") {
+      if (!ParseCount(next_arg(i, arg), INT_MAX, count))
+        return invalid_value(arg, args[i]);
+      headless_options.cycles_per_frame = static_cast<int>(count);
+      grid_options.cycles_per_frame = headless_options.cycles_per_frame;
+    } else if (arg == "--grid") {
+      grid = true;
+    } else if (arg == "--seeds") {
+      if (!ParseCount(next_arg(i, arg), 65536, count))
+        return invalid_value(arg, args[i]);
+      grid_options.seeds = count;
+    } else if (arg == "--threads") {
+      if (!ParseCount(next_arg(i, arg), MAX_THREAD_COUNT, count))
+        return invalid_value(arg, args[i]);
+      grid_options.threads = count;
     } else {
-      // Assume this is the ROM path
-      if (romPath.empty()) {
-        romPath = arg;
+      // Assume this is the ROM path (grid mode takes many)
+      if (romPaths.empty() || grid) {
+        romPaths.push_back(arg);
       } else {
         std::cerr << "Error: Unexpected argument '" << arg << "'\n";
         CLI::print_usage(args[0]);
@@ -783,18 +1667,82 @@ int main(int argc, char *args[]) {
     }
   }
 
-  if (romPath.empty()) {
+  if (romPaths.empty()) {
     std::cerr << "Error: No ROM path specified\n";
     CLI::print_usage(args[0]);
     return EXIT_FAILURE;
   }
 
+  if (grid && hot_reload) {
+    std::cerr << "Error: --hot-reload does not work with --grid\n";
+    CLI::print_usage(args[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (grid && grid_options.seeds > 0 && romPaths.size() != 1) {
+    std::cerr << "Error: --seeds takes exactly one ROM\n";
+    CLI::print_usage(args[0]);
+    return EXIT_FAILURE;
+  }
+
   try {
-    auto rom = LoadRomFromFile(romPath);
+    if (grid) {
+      std::vector<std::vector<uint8_t>> roms;
+      for (const auto &path : romPaths) {
+        roms.push_back(LoadRomFromFile(path));
+      }
+
+      GridEmulator emu(roms, grid_options);
+      emu.Run();
+
+      return EXIT_SUCCESS;
+    }
+
+    // with --hot-reload the ROM is assembled from source in-process
+    std::unique_ptr<HotReloader> hot_reloader;
+    std::vector<uint8_t> rom;
+    if (hot_reload) {
+      hot_reloader = std::make_unique<HotReloader>(romPaths.front());
+      rom = hot_reloader->GetBytes();
+      emulator_options.hot_reloader = hot_reloader.get();
+    } else {
+      rom = LoadRomFromFile(romPaths.front());
+    }
+
     Chip8 cpu;
     cpu.LoadFromArray(rom.data(), rom.size());
 
-    Emulator emu(cpu, mode);
+    if (headless) {
+      // FxFF is how a test ROM ends a --frames 0 run
+      cpu.AllowCustomInstructions(true);
+      RunHeadless(cpu, headless_options);
+      return EXIT_SUCCESS;
+    }
+
+    // ch8asm -g writes it next to the ROM
+    std::unique_ptr<DebugInfo> debug_info;
+    const bool debug_info_given = !debug_info_path.empty();
+    if (!debug_info_given && !hot_reload) {
+      std::error_code ec;
+      if (std::filesystem::exists(romPaths.front() + ".dbg", ec))
+        debug_info_path = romPaths.front() + ".dbg";
+    }
+    if (!debug_info_path.empty()) {
+      debug_info = std::make_unique<DebugInfo>(debug_info_path);
+
+      // a stale file would point the debugger at the wrong source lines
+      if (!debug_info->MatchesRom(rom.data(), rom.size())) {
+        if (debug_info_given)
+          throw std::runtime_error(debug_info_path + " was not built from " +
+                                   romPaths.front());
+        std::cerr << "warning: ignoring " << debug_info_path
+                  << ", it was built from a different ROM\n";
+        debug_info.reset();
+      }
+      emulator_options.debug_info = debug_info.get();
+    }
+
+    Emulator emu(cpu, mode, emulator_options);
     emu.Run();
 
     return EXIT_SUCCESS;
@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "include/disassembler/rom_stats.hpp"
+#include "include/instruction.hpp"
+#include "include/utils/batch.hpp"
+#include "include/utils/mapped_file.hpp"
+#include "include/utils/parse_count.hpp"
+
+namespace fs = std::filesystem;
+
+constexpr auto VERSION = 0.1;
+
+void print_help() {
+  std::cout << "usage: ch8scan <input>... [-o <file>] [--threads <n>] "
+               "[--ext <ext>] [--help] [--version]\n";
+  std::cout << "options:\n"
+            << "  <input>         a ROM, a glob, a directory to search or - "
+               "for a list of\n"
+            << "                  paths on stdin\n"
+            << "  -o, --output <file>\n"
+            << "                  where the JSON lines go (default: - for "
+               "stdout)\n"
+            << "  --threads <n>   worker threads (default: 0, all cores)\n"
+            << "  --ext <ext>     extension of the ROMs in directories "
+               "(default: .ch8)\n"
+            << "  --help          show this help message\n"
+            << "  --version       show version info\n";
+  std::cout << "\none line per ROM in input order, then one with the "
+               "totals:\n"
+            << "  {\"type\":\"rom\",\"path\":...,\"size\":...,"
+               "\"instructions\":...,\"code_bytes\":...,\n"
+            << "   \"jump_tables\":...,\"key_waits\":...,"
+               "\"self_modifying\":[\"0x2a4\"],\n"
+            << "   \"stops\":{\"0x2f0\":\"00ff\"},\"extensions\":[\"schip\"],\n"
+            << "   \"quirks\":{\"shifts_reading_vy\":...,"
+               "\"zero_height_draws\":...},\n"
+            << "   \"histogram\":{\"00E0\":1,...}}\n"
+            << "  {\"type\":\"total\",\"roms\":...,\"failed\":...,...,"
+               "\"roms_using\":{\"00E0\":...},\n"
+            << "   \"roms_extending\":{\"schip\":...}}\n"
+            << "stops are the opcodes a path ran into and could not follow, "
+               "extensions the\n"
+            << "families they belong to: schip, xo-chip, ch8emu, "
+               "machine-code or unknown.\n";
+}
+
+void print_version() {
+  std::cout << "ch8scan nuts version " << VERSION << "\n";
+}
+
+// ====== Inputs ======
+// directories are searched for files ending in `extension`, in path order
+std::vector<std::string> find_roms(const std::vector<std::string> &args,
+                                   const std::string &extension) {
+  std::vector<std::string> roms;
+  for (const auto &input : ExpandInputs(args)) {
+    std::error_code ec;
+    if (!fs::is_directory(input, ec)) {
+      roms.push_back(input);
+      continue;
+    }
+
+    std::vector<std::string> found;
+    for (fs::recursive_directory_iterator
+             it(input, fs::directory_options::skip_permission_denied, ec),
+         end;
+         !ec && it != end; it.increment(ec)) {
+      if (it->is_regular_file(ec) && it->path().extension() == extension)
+        found.push_back(it->path().string());
+    }
+    if (ec)
+      throw std::runtime_error("failed to search " + input + ": " +
+                               ec.message());
+
+    std::sort(found.begin(), found.end());
+    roms.insert(roms.end(), found.begin(), found.end());
+  }
+  // a ROM named directly and found in a directory is scanned once
+  RemoveDuplicateInputs(roms);
+  return roms;
+}
+
+// ====== JSON ======
+void append_string(std::string &out, std::string_view text) {
+  out += '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out += escaped;
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+}
+
+void append_field(std::string &out, const char *name, uint64_t value) {
+  out += ",\"";
+  out += name;
+  out += "\":";
+  out += std::to_string(value);
+}
+
+// {"00E0":1,...}, kinds with a count of 0 left out
+template <typename Count>
+void append_histogram(std::string &out, const char *name,
+                      const Count (&counts)[INSTRUCTION_KIND_COUNT]) {
+  out += ",\"";
+  out += name;
+  out += "\":{";
+  bool first = true;
+  for (size_t kind = 0; kind < INSTRUCTION_KIND_COUNT; kind += 1) {
+    if (counts[kind] == 0)
+      continue;
+    if (!first)
+      out += ',';
+    first = false;
+    append_string(out, INSTRUCTION_FORMS[kind].pattern);
+    out += ':';
+    out += std::to_string(counts[kind]);
+  }
+  out += '}';
+}
+
+std::string rom_record(const std::string &path, const RomStats &stats) {
+  std::string out = "{\"type\":\"rom\",\"path\":";
+  append_string(out, path);
+  append_field(out, "size", stats.size);
+  append_field(out, "instructions", stats.instruction_count);
+  append_field(out, "code_bytes", stats.code_bytes);
+  append_field(out, "jump_tables", stats.Count(InstructionKind::JP_V0));
+  append_field(out, "key_waits", stats.Count(InstructionKind::LD_KEY));
+
+  out += ",\"self_modifying\":[";
+  for (size_t i = 0; i < stats.self_modifying.size(); i += 1) {
+    char addr[16];
+    std::snprintf(addr, sizeof(addr), "\"0x%03x\"", stats.self_modifying[i]);
+    if (i > 0)
+      out += ',';
+    out += addr;
+  }
+  out += ']';
+
+  out += ",\"stops\":{";
+  for (size_t i = 0; i < stats.stops.size(); i += 1) {
+    char stop[32];
+    std::snprintf(stop, sizeof(stop), "\"0x%03x\":\"%04x\"",
+                  stats.stops[i].address, stats.stops[i].opcode);
+    if (i > 0)
+      out += ',';
+    out += stop;
+  }
+  out += '}';
+
+  out += ",\"extensions\":[";
+  bool first = true;
+  for (size_t extension = 0; extension < EXTENSION_COUNT; extension += 1) {
+    if (stats.extensions[extension] == 0)
+      continue;
+    if (!first)
+      out += ',';
+    first = false;
+    append_string(out, ExtensionName(static_cast<Extension>(extension)));
+  }
+  out += ']';
+
+  out += ",\"quirks\":{";
+  out += "\"shifts_reading_vy\":" + std::to_string(stats.shifts_reading_vy);
+  append_field(out, "zero_height_draws", stats.zero_height_draws);
+  out += '}';
+
+  append_histogram(out, "histogram", stats.histogram);
+  out += "}\n";
+  return out;
+}
+
+// ====== Totals ======
+struct Totals {
+  uint64_t roms = 0;
+  uint64_t bytes = 0;
+  uint64_t instructions = 0;
+  uint64_t code_bytes = 0;
+  uint64_t jump_table_roms = 0;
+  uint64_t key_wait_roms = 0;
+  uint64_t self_modifying_roms = 0;
+  uint64_t shifts_reading_vy_roms = 0;
+  uint64_t zero_height_draw_roms = 0;
+  uint64_t extension_roms[EXTENSION_COUNT]{}; // ROMs stopping at each family
+  uint64_t histogram[INSTRUCTION_KIND_COUNT]{};
+  uint64_t roms_using[INSTRUCTION_KIND_COUNT]{}; // ROMs reaching each kind
+
+  void Add(const RomStats &stats) {
+    roms += 1;
+    bytes += stats.size;
+    instructions += stats.instruction_count;
+    code_bytes += stats.code_bytes;
+    jump_table_roms += stats.Count(InstructionKind::JP_V0) > 0;
+    key_wait_roms += stats.Count(InstructionKind::LD_KEY) > 0;
+    self_modifying_roms += !stats.self_modifying.empty();
+    shifts_reading_vy_roms += stats.shifts_reading_vy > 0;
+    zero_height_draw_roms += stats.zero_height_draws > 0;
+    for (size_t extension = 0; extension < EXTENSION_COUNT; extension += 1)
+      extension_roms[extension] += stats.extensions[extension] > 0;
+    for (size_t kind = 0; kind < INSTRUCTION_KIND_COUNT; kind += 1) {
+      histogram[kind] += stats.histogram[kind];
+      roms_using[kind] += stats.histogram[kind] > 0;
+    }
+  }
+};
+
+std::string total_record(const Totals &totals, size_t failed) {
+  std::string out = "{\"type\":\"total\"";
+  append_field(out, "roms", totals.roms);
+  append_field(out, "failed", failed);
+  append_field(out, "bytes", totals.bytes);
+  append_field(out, "instructions", totals.instructions);
+  append_field(out, "code_bytes", totals.code_bytes);
+  append_field(out, "jump_table_roms", totals.jump_table_roms);
+  append_field(out, "key_wait_roms", totals.key_wait_roms);
+  append_field(out, "self_modifying_roms", totals.self_modifying_roms);
+  append_field(out, "shifts_reading_vy_roms", totals.shifts_reading_vy_roms);
+  append_field(out, "zero_height_draw_roms", totals.zero_height_draw_roms);
+
+  out += ",\"roms_extending\":{";
+  for (size_t extension = 0; extension < EXTENSION_COUNT; extension += 1) {
+    if (extension > 0)
+      out += ',';
+    append_string(out, ExtensionName(static_cast<Extension>(extension)));
+    out += ':';
+    out += std::to_string(totals.extension_roms[extension]);
+  }
+  out += '}';
+
+  append_histogram(out, "histogram", totals.histogram);
+  append_histogram(out, "roms_using", totals.roms_using);
+  out += "}\n";
+  return out;
+}
+
+// ====== Scan ======
+int scan(const std::vector<std::string> &args, const std::string &output,
+         size_t threads, const std::string &extension) {
+  const std::vector<std::string> roms = find_roms(args, extension);
+
+  // filled in parallel, written in input order once the batch is done
+  std::vector<RomStats> stats(roms.size());
+  std::vector<std::string> records(roms.size());
+  const auto report = RunBatch(roms, threads, [&](const std::string &rom) {
+    const size_t i = &rom - roms.data();
+    const MappedFile file(rom);
+    stats[i] = AnalyzeRom(file.data(), file.size());
+    records[i] = rom_record(rom, stats[i]);
+    return BatchJobResult{file.size(), records[i].size()};
+  });
+
+  std::ofstream file;
+  if (output != "-") {
+    file.open(output, std::ios::binary);
+    if (!file) {
+      throw std::runtime_error("failed to open file for writing: " + output);
+    }
+  }
+  std::ostream &out = output == "-" ? std::cout : file;
+
+  // a failed ROM has no record
+  Totals totals;
+  for (size_t i = 0; i < roms.size(); i += 1) {
+    if (records[i].empty())
+      continue;
+    out << records[i];
+    totals.Add(stats[i]);
+  }
+  out << total_record(totals, report.failed);
+  out.flush();
+  if (!out) {
+    throw std::runtime_error("failed to write data to file: " + output);
+  }
+
+  std::cerr << "scanned ";
+  PrintBatchReport(std::cerr, report);
+  return report.failed ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "error: no input provided.\n";
+    print_help();
+    return 1;
+  }
+
+  std::vector<std::string> inputs;
+  std::string output = "-";
+  size_t threads = 0;
+  std::string extension = ".ch8";
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+
+    if (arg == "--help") {
+      print_help();
+      return 0;
+    } else if (arg == "--version") {
+      print_version();
+      return 0;
+    } else if (arg == "-o" || arg == "--output") {
+      if (i + 1 < argc) {
+        output = argv[++i];
+      } else {
+        std::cerr << "error: " << arg << " requires an argument.\n";
+        return 1;
+      }
+    } else if (arg == "--threads") {
+      uint64_t count = 0;
+      if (i + 1 >= argc) {
+        std::cerr << "error: --threads requires an argument.\n";
+        return 1;
+      } else if (ParseCount(argv[++i], MAX_THREAD_COUNT, count)) {
+        threads = count;
+      } else {
+        std::cerr << "error: --threads takes a count from 0 to "
+                  << MAX_THREAD_COUNT << ", got '" << argv[i] << "'.\n";
+        return 1;
+      }
+    } else if (arg == "--ext") {
+      if (i + 1 < argc) {
+        extension = argv[++i];
+        if (!extension.empty() && extension[0] != '.')
+          extension.insert(extension.begin(), '.');
+      } else {
+        std::cerr << "error: --ext requires an argument.\n";
+        return 1;
+      }
+    } else if (arg.empty() || arg[0] != '-' || arg == "-") {
+      inputs.push_back(arg);
+    } else {
+      std::cerr << "unknown argument: " << arg << "\n";
+      return 1;
+    }
+  }
+
+  try {
+    return scan(inputs, output, threads, extension);
+  } catch (const std::exception &e) {
+    std::cerr << "scan error: " << e.what() << "\n";
+    return 1;
+  }
+}
@@ -4,66 +4,109 @@
 #include <cctype>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "module.hpp"
 #include "tokenizer.hpp"
 
 class Assembler {
 
+  // reuses the line encoder and label table
+  friend class IncrementalAssembler;
+  // walks the token lines of a relocatable build
+  friend class Optimizer;
+
 private:
   Tokenizer tkzr;
   std::vector<uint8_t> bytes;
-  std::unordered_map<std::string, uint16_t> label_table;
+  // keys point into the tokenizer's source buffer
+  std::unordered_map<std::string_view, uint16_t> label_table;
+
+  // an opcode whose 12-bit address refers to a label not yet defined
+  struct Fixup {
+    size_t offset; // of the opcode's high byte in bytes
+    std::string_view label;
+  };
+  std::vector<Fixup> fixups;
+  // output offset of the instruction being encoded
+  size_t encode_offset = 0;
 
   // ====== Stages ======
-  void run_first_pass();
+  void define_label(std::string_view label, uint16_t PC);
+  void resolve_fixups();
+
+  // ====== Lines ======
+  static const char *const INCLUDE_NEEDS_FILE;
+  static std::string_view label_name(const TokenLine &line);
+  static size_t body_start(const TokenLine &line);
+  static bool is_include(const TokenLine &line);
+  // bytes the line assembles to: 0 for a lone label
+  static size_t line_size(const TokenLine &line);
+  // writes line_size(line) bytes at bytes[offset]
+  void encode_line(const TokenLine &line, size_t offset);
 
   // ====== Checkers ======
   bool is_immediate_or_label(const Token &tk);
+  bool is_special_register(const Token &tk, SpecialRegister reg);
+  bool is_special_mnemonic(const Token &tk, SpecialMnemonic sm);
 
   // ====== Parsing helpers ======
-  uint16_t parse_immediate(const std::string &s);
-  uint8_t parse_register(const std::string &s);
+  uint16_t parse_immediate(std::string_view s);
+  uint8_t parse_register(const Token &tk);
   uint16_t resolve_immediate_and_label(const Token &tk);
   void throw_invalid_instruction(const char *MNEMONIC,
-                                 const std::vector<Token> &line) const;
+                                 const TokenLine &line) const;
 
   // ====== Instruction parsers ======
-  uint16_t parse_CLS(std::vector<Token> &line);
-  uint16_t parse_RET(std::vector<Token> &line);
+  typedef uint16_t (Assembler::*InstructionParser)(const TokenLine &line);
+
+  uint16_t parse_CLS(const TokenLine &line);
+  uint16_t parse_RET(const TokenLine &line);
+
+  uint16_t parse_JP(const TokenLine &line);
+  uint16_t parse_CALL(const TokenLine &line);
+  uint16_t parse_SE(const TokenLine &line);
+  uint16_t parse_SNE(const TokenLine &line);
+  uint16_t parse_ADD(const TokenLine &line);
 
-  uint16_t parse_JP(const std::vector<Token> &line);
-  uint16_t parse_CALL(const std::vector<Token> &line);
-  uint16_t parse_SE(std::vector<Token> &line);
-  uint16_t parse_SNE(std::vector<Token> &line);
-  uint16_t parse_ADD(std::vector<Token> &line);
+  uint16_t parse_AND(const TokenLine &line);
+  uint16_t parse_OR(const TokenLine &line);
+  uint16_t parse_XOR(const TokenLine &line);
 
-  uint16_t parse_AND(std::vector<Token> &line);
-  uint16_t parse_OR(std::vector<Token> &line);
-  uint16_t parse_XOR(std::vector<Token> &line);
+  uint16_t parse_SUB(const TokenLine &line);
+  uint16_t parse_SUBN(const TokenLine &line);
 
-  uint16_t parse_SUB(std::vector<Token> &line);
-  uint16_t parse_SUBN(std::vector<Token> &line);
+  uint16_t parse_LD(const TokenLine &line);
+  uint16_t parse_RND(const TokenLine &line);
 
-  uint16_t parse_LD(std::vector<Token> &line);
-  uint16_t parse_RND(std::vector<Token> &line);
+  uint16_t parse_SKP(const TokenLine &line);
+  uint16_t parse_SKNP(const TokenLine &line);
 
-  uint16_t parse_SKP(std::vector<Token> &line);
-  uint16_t parse_SKNP(std::vector<Token> &line);
+  uint16_t parse_DRW(const TokenLine &line);
 
-  uint16_t parse_DRW(std::vector<Token> &line);
+  uint16_t parse_SHR(const TokenLine &line);
+  uint16_t parse_SHL(const TokenLine &line);
 
-  uint16_t parse_SHR(std::vector<Token> &line);
-  uint16_t parse_SHL(std::vector<Token> &line);
+  uint16_t assemble_instruction(const TokenLine &line);
 
-  uint16_t assemble_instruction(std::vector<Token> line);
+  // with a module, labels and includes are recorded in it instead of being
+  // resolved
+  Assembler(std::string_view source_code, Module *module);
 
 public:
-  Assembler(std::string source_code);
+  Assembler(std::string_view source_code);
+
+  // assembles one file of a multi-file program, see Linker
+  static Module AssembleModule(std::string_view source_code);
 
   static Assembler FromFile(const std::string &filename);
 
+  // the nnn field of an opcode referring to a label at addr, throws when
+  // the label lies past what 12 bits address
+  static uint16_t AddressOperand(std::string_view label, uint32_t addr);
+
   std::vector<uint8_t> GetBytes() const;
 
   void WriteToFile(std::string path) const;
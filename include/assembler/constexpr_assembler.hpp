@@ -0,0 +1,386 @@
+#ifndef CONSTEXPR_ASSEMBLER_4_CHIP8_HPP
+#define CONSTEXPR_ASSEMBLER_4_CHIP8_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#include "../instruction.hpp"
+#include "tokenizer.hpp"
+
+// Compile-time assembler for programs embedded in C++ sources:
+//
+//   constexpr auto rom = CHIP8_ASSEMBLE(R"(
+//   loop:
+//       ADD V0, 1
+//       JP loop
+//   )");
+//
+// `rom` is a std::array<uint8_t, N> holding the same bytes Assembler would
+// produce. Words are classified by the tokenizer's own ClassifyWord, and the
+// instruction forms mirror Assembler::assemble_instruction. A syntax error
+// is a throw reached during constant evaluation, so it fails the build.
+// `.include` is not supported.
+#define CHIP8_ASSEMBLE(source)                                                 \
+  ConstexprAssembler::Assemble<ConstexprAssembler::AssembledSize(source)>(     \
+      source)
+
+namespace ConstexprAssembler {
+
+// ====== Lines ======
+// bounds `.byte` lines to 31 values
+constexpr size_t MAX_LINE_TOKENS = 32;
+
+constexpr Token NO_TOKEN = {TokenType::Unknown, {}, 0};
+
+struct Line {
+  Token tokens[MAX_LINE_TOKENS]{};
+  size_t count = 0;
+
+  constexpr size_t size() const { return count; }
+  constexpr bool empty() const { return count == 0; }
+  constexpr const Token &operator[](size_t i) const {
+    return i < count ? tokens[i] : NO_TOKEN;
+  }
+};
+
+constexpr bool is_separator(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// tokenizes the line starting at `pos`, returns the start of the next one
+constexpr size_t read_line(std::string_view src, size_t pos, Line &line) {
+  line = Line{};
+
+  while (pos < src.size() && src[pos] != '\n') {
+    const char c = src[pos];
+
+    if (is_separator(c)) {
+      pos += 1;
+    } else if (c == ';') {
+      while (pos < src.size() && src[pos] != '\n')
+        pos += 1;
+    } else {
+      size_t end = pos + 1;
+      if (c != ',') {
+        while (end < src.size() && !is_separator(src[end]) &&
+               src[end] != '\n' && src[end] != ';' && src[end] != ',')
+          end += 1;
+      }
+
+      if (line.count == MAX_LINE_TOKENS)
+        throw std::invalid_argument("too many tokens on one line");
+
+      line.tokens[line.count] =
+          ClassifyWord(src.substr(pos, end - pos), line.count);
+      line.count += 1;
+      pos = end;
+    }
+  }
+
+  return pos + 1; // past '\n'
+}
+
+constexpr size_t body_start(const Line &line) {
+  return !line.empty() && line[0].type == TokenType::LabelDef ? 1 : 0;
+}
+
+// same as Assembler::line_size
+constexpr size_t line_size(const Line &line) {
+  const size_t start = body_start(line);
+  if (start == line.size())
+    return 0;
+
+  if (line[start].type == TokenType::IncludeDirective)
+    throw std::invalid_argument(".include is not supported at compile time");
+
+  if (line[start].type != TokenType::ByteDirective)
+    return 2;
+
+  size_t byte_count = 0;
+  for (size_t i = start + 1; i < line.size(); i += 1) {
+    if (line[i].type == TokenType::Immediate)
+      byte_count += 1;
+  }
+  return byte_count;
+}
+
+// ====== Operands ======
+constexpr uint16_t parse_immediate(std::string_view s) {
+  const bool hex = s.substr(0, 2) == "0x" || s.substr(0, 2) == "0X";
+  if (hex)
+    s.remove_prefix(2);
+
+  // digits up to the first invalid character, like Assembler
+  uint32_t value = 0;
+  size_t digits = 0;
+  for (char c : s) {
+    if (!(c >= '0' && c <= '9') && !(hex && IsHexDigit(c)))
+      break;
+
+    value = value * (hex ? 16 : 10) + HexDigitValue(c);
+    if (value > 0xFFFF)
+      throw std::invalid_argument("immediate value out of range");
+    digits += 1;
+  }
+
+  if (digits == 0)
+    throw std::invalid_argument("invalid immediate value");
+
+  return value;
+}
+
+constexpr uint16_t parse_byte(const Token &tk) {
+  const uint16_t kk = parse_immediate(tk.text);
+  if (kk > 0xFF)
+    throw std::invalid_argument("immediate value out of range for a byte");
+  return kk;
+}
+
+// address of the first definition of `name`
+constexpr uint16_t find_label(std::string_view src, std::string_view name) {
+  uint16_t PC = 0x200;
+  size_t pos = 0;
+  Line line;
+  while (pos < src.size()) {
+    pos = read_line(src, pos, line);
+    if (body_start(line) == 1 &&
+        line[0].text.substr(0, line[0].text.size() - 1) == name) {
+      if (PC > 0xFFF)
+        throw std::invalid_argument("label address out of range ( <= 0xFFF)");
+      return PC;
+    }
+    PC += line_size(line);
+  }
+
+  throw std::invalid_argument("unknown label");
+}
+
+constexpr bool is_immediate_or_label(const Token &tk) {
+  return tk.type == TokenType::Immediate || tk.type == TokenType::LabelRef;
+}
+
+constexpr uint16_t resolve(std::string_view src, const Token &tk) {
+  return tk.type == TokenType::Immediate ? parse_immediate(tk.text)
+                                         : find_label(src, tk.text);
+}
+
+constexpr bool is(const Token &tk, TokenType type) { return tk.type == type; }
+
+constexpr bool is(const Token &tk, SpecialRegister reg) {
+  return tk.type == TokenType::SpecialRegister &&
+         tk.value == static_cast<uint8_t>(reg);
+}
+
+constexpr bool is(const Token &tk, SpecialMnemonic sm) {
+  return tk.type == TokenType::SpecialMnemonic &&
+         tk.value == static_cast<uint8_t>(sm);
+}
+
+// ====== Instructions ======
+constexpr uint16_t encode_instruction(std::string_view src, const Line &line) {
+  constexpr TokenType Reg = TokenType::Register;
+  constexpr TokenType Comma = TokenType::Comma;
+  constexpr TokenType Imm = TokenType::Immediate;
+
+  // operand shapes shared by most instructions
+  const bool reg_reg =
+      is(line[1], Reg) && is(line[2], Comma) && is(line[3], Reg);
+  const bool reg_imm =
+      is(line[1], Reg) && is(line[2], Comma) && is(line[3], Imm);
+  const uint8_t x = line[1].value;
+  const uint8_t y = line[3].value;
+
+  // any case, like Assembler. a label definition in front of an instruction
+  // is not a mnemonic, so it is rejected there too
+  const Mnemonic mnemonic =
+      line[0].type == TokenType::Mnemonic
+          ? static_cast<Mnemonic>(line[0].value)
+          : MnemonicFromText(line[0].text, true);
+
+  switch (mnemonic) {
+  case Mnemonic::CLS:
+    return EncodeInstruction(InstructionKind::CLS);
+  case Mnemonic::RET:
+    return EncodeInstruction(InstructionKind::RET);
+  case Mnemonic::JP:
+    if (line.size() == 2 && is_immediate_or_label(line[1]))
+      return EncodeInstruction(InstructionKind::JP, 0, 0,
+                               resolve(src, line[1]));
+    if (line.size() == 4 && is(line[1], Reg) && line[1].value == 0 &&
+        is(line[2], Comma) && is_immediate_or_label(line[3]))
+      return EncodeInstruction(InstructionKind::JP_V0, 0, 0,
+                               resolve(src, line[3]));
+    break;
+  case Mnemonic::CALL:
+    if (line.size() == 2 && is_immediate_or_label(line[1]))
+      return EncodeInstruction(InstructionKind::CALL, 0, 0,
+                               resolve(src, line[1]));
+    break;
+  case Mnemonic::SE:
+    if (reg_imm)
+      return EncodeInstruction(InstructionKind::SE_BYTE, x, 0,
+                               parse_byte(line[3]));
+    if (reg_reg)
+      return EncodeInstruction(InstructionKind::SE_REG, x, y);
+    break;
+  case Mnemonic::SNE:
+    if (reg_imm)
+      return EncodeInstruction(InstructionKind::SNE_BYTE, x, 0,
+                               parse_byte(line[3]));
+    if (reg_reg)
+      return EncodeInstruction(InstructionKind::SNE_REG, x, y);
+    break;
+  case Mnemonic::ADD:
+    if (reg_imm)
+      return EncodeInstruction(InstructionKind::ADD_BYTE, x, 0,
+                               parse_byte(line[3]));
+    if (reg_reg)
+      return EncodeInstruction(InstructionKind::ADD_REG, x, y);
+    if (is(line[1], SpecialRegister::I) && is(line[2], Comma) &&
+        is(line[3], Reg))
+      return EncodeInstruction(InstructionKind::ADD_I, line[3].value);
+    break;
+  case Mnemonic::OR:
+    if (line.size() == 4 && reg_reg)
+      return EncodeInstruction(InstructionKind::OR, x, y);
+    break;
+  case Mnemonic::AND:
+    if (line.size() == 4 && reg_reg)
+      return EncodeInstruction(InstructionKind::AND, x, y);
+    break;
+  case Mnemonic::XOR:
+    if (line.size() == 4 && reg_reg)
+      return EncodeInstruction(InstructionKind::XOR, x, y);
+    break;
+  case Mnemonic::SUB:
+    if (line.size() == 4 && reg_reg)
+      return EncodeInstruction(InstructionKind::SUB, x, y);
+    break;
+  case Mnemonic::SUBN:
+    if (line.size() == 4 && reg_reg)
+      return EncodeInstruction(InstructionKind::SUBN, x, y);
+    break;
+  case Mnemonic::LD: {
+    if (line.size() != 4)
+      break;
+    const uint8_t vx3 = line[3].value; // LD <special>, Vx
+    if (reg_imm)
+      return EncodeInstruction(InstructionKind::LD_BYTE, x, 0,
+                               parse_byte(line[3]));
+    if (reg_reg)
+      return EncodeInstruction(InstructionKind::LD_REG, x, y);
+    if (is(line[1], SpecialRegister::I) && is(line[2], Comma) &&
+        is_immediate_or_label(line[3])) {
+      const uint16_t addr = resolve(src, line[3]);
+      if (addr > 0xFFF)
+        throw std::invalid_argument(
+            "immediate value out of range ( <= 0xFFF)");
+      return EncodeInstruction(InstructionKind::LD_I, 0, 0, addr);
+    }
+    if (!is(line[2], Comma))
+      break;
+    if (is(line[1], TokenType::MemoryDereference) && is(line[3], Reg))
+      return EncodeInstruction(InstructionKind::STORE, vx3);
+    if (is(line[1], Reg) && is(line[3], TokenType::MemoryDereference))
+      return EncodeInstruction(InstructionKind::LOAD, x);
+    if (is(line[1], Reg) && is(line[3], SpecialRegister::DT))
+      return EncodeInstruction(InstructionKind::LD_FROM_DT, x);
+    if (is(line[1], SpecialRegister::DT) && is(line[3], Reg))
+      return EncodeInstruction(InstructionKind::LD_DT, vx3);
+    if (is(line[1], SpecialRegister::ST) && is(line[3], Reg))
+      return EncodeInstruction(InstructionKind::LD_ST, vx3);
+    if (is(line[1], SpecialMnemonic::F) && is(line[3], Reg))
+      return EncodeInstruction(InstructionKind::LD_FONT, vx3);
+    if (is(line[1], SpecialMnemonic::B) && is(line[3], Reg))
+      return EncodeInstruction(InstructionKind::LD_BCD, vx3);
+    if (is(line[1], Reg) && is(line[3], SpecialMnemonic::K))
+      return EncodeInstruction(InstructionKind::LD_KEY, x);
+    break;
+  }
+  case Mnemonic::RND:
+    if (reg_imm)
+      return EncodeInstruction(InstructionKind::RND, x, 0,
+                               parse_byte(line[3]));
+    break;
+  case Mnemonic::DRW:
+    if (reg_reg && is(line[4], Comma) && is(line[5], Imm)) {
+      const uint16_t n = parse_immediate(line[5].text);
+      if (n > 0xF)
+        throw std::invalid_argument(
+            "immediate value out of range for a nibble");
+      return EncodeInstruction(InstructionKind::DRW, x, y, n);
+    }
+    break;
+  case Mnemonic::SKP:
+    if (is(line[1], Reg))
+      return EncodeInstruction(InstructionKind::SKP, x);
+    break;
+  case Mnemonic::SKNP:
+    if (is(line[1], Reg))
+      return EncodeInstruction(InstructionKind::SKNP, x);
+    break;
+  case Mnemonic::SHR:
+    if (is(line[1], Reg))
+      return EncodeInstruction(InstructionKind::SHR, x);
+    break;
+  case Mnemonic::SHL:
+    if (is(line[1], Reg))
+      return EncodeInstruction(InstructionKind::SHL, x);
+    break;
+  case Mnemonic::None:
+    break;
+  }
+
+  throw std::invalid_argument("invalid instruction");
+}
+
+// ====== Entry points ======
+constexpr size_t AssembledSize(std::string_view src) {
+  size_t size = 0;
+  size_t pos = 0;
+  Line line;
+  while (pos < src.size()) {
+    pos = read_line(src, pos, line);
+    size += line_size(line);
+  }
+  return size;
+}
+
+// N must be AssembledSize(src), see CHIP8_ASSEMBLE
+template <size_t N>
+constexpr std::array<uint8_t, N> Assemble(std::string_view src) {
+  std::array<uint8_t, N> rom{};
+  size_t out = 0;
+
+  size_t pos = 0;
+  Line line;
+  while (pos < src.size()) {
+    pos = read_line(src, pos, line);
+    const size_t start = body_start(line);
+    if (line_size(line) == 0)
+      continue;
+
+    if (line[start].type == TokenType::ByteDirective) {
+      for (size_t i = start + 1; i < line.size(); i += 1) {
+        if (line[i].type == TokenType::Immediate)
+          rom[out++] = parse_byte(line[i]);
+      }
+    } else {
+      const uint16_t opcode = encode_instruction(src, line);
+      rom[out++] = opcode >> 8u;
+      rom[out++] = opcode & 0x00FFu;
+    }
+  }
+
+  if (out != N)
+    throw std::invalid_argument("size does not match AssembledSize()");
+
+  return rom;
+}
+
+} // namespace ConstexprAssembler
+
+#endif
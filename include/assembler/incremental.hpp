@@ -0,0 +1,70 @@
+#ifndef INCREMENTAL_ASSEMBLER_4_CHIP8_HPP
+#define INCREMENTAL_ASSEMBLER_4_CHIP8_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "assembler.hpp"
+#include "tokenizer.hpp"
+
+// Re-assembles a source after edits without starting over. The token lines,
+// label table and per-line output offsets of the previous run are kept; an
+// update re-tokenizes and re-encodes only the lines that differ, plus the
+// instructions whose label target moved. Output is identical to Assembler.
+class IncrementalAssembler {
+
+public:
+  struct UpdateStats {
+    size_t lines_tokenized = 0;
+    size_t lines_encoded = 0;
+    bool full = false; // everything was assembled from scratch
+  };
+
+  IncrementalAssembler();
+
+  // the first call assembles everything. On error the previous output is
+  // kept and the next call starts from scratch.
+  UpdateStats Update(std::string_view source);
+
+  const std::vector<uint8_t> &GetBytes() const;
+  // keys are views into the kept token lines, valid until the next Update
+  const std::unordered_map<std::string_view, uint16_t> &GetLabelTable() const;
+
+  void WriteToFile(const std::string &path) const;
+
+private:
+  // tokenized runs of lines are kept until there are this many, then the
+  // whole source is tokenized again
+  static constexpr size_t MAX_CHUNKS = 32;
+
+  struct Line {
+    TokenLine tokens;
+    size_t offset = 0; // into the output
+    size_t size = 0;
+    bool has_label_ref = false;
+  };
+
+  // the encoder; its bytes and label table are the current output
+  Assembler assembler;
+  std::vector<uint8_t> output;
+
+  // the source of the last successful update and its lines
+  std::vector<char> source;
+  std::vector<std::string_view> line_text;
+
+  // every tokenizer a kept line points into
+  std::vector<Tokenizer> chunks;
+  std::vector<Line> lines;
+  bool valid = false;
+
+  UpdateStats rebuild(std::string_view next_source);
+
+  static std::vector<std::string_view> split_lines(std::string_view s);
+  static Line make_line(const TokenLine &tokens);
+};
+
+#endif
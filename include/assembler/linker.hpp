@@ -0,0 +1,72 @@
+#ifndef LINKER_4_CHIP8_HPP
+#define LINKER_4_CHIP8_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../debug/debug_info.hpp"
+#include "../utils/artifact_cache.hpp"
+#include "module.hpp"
+
+struct LinkOptions {
+  ArtifactCache *cache = nullptr; // modules by source hash, null disables
+  size_t threads = 0;             // 0 uses every core
+};
+
+// Multi-file front end. Every input, and every file reached through
+// `.include "<file>"`, is assembled into a Module of its own. Include paths
+// are relative to the including file.
+//
+// Modules are loaded one level of the include graph at a time, and each
+// level is tokenized and encoded in parallel. With a cache, a module whose
+// source hash is already cached is read back instead of being assembled, so
+// only files that changed are rebuilt.
+//
+// The image is laid out in source order. The inputs come one after another,
+// and each include is replaced by the file it names. A file is placed only
+// once, at its first include. All modules share one label table.
+class Linker {
+public:
+  struct Stats {
+    size_t modules = 0;
+    size_t cached = 0; // read back from the cache
+  };
+
+  Linker(const std::vector<std::string> &inputs,
+         const LinkOptions &options = {});
+
+  const std::vector<uint8_t> &GetBytes() const;
+  const std::unordered_map<std::string, uint16_t> &GetLabelTable() const;
+  const Stats &GetStats() const;
+
+  // for debug info: every file linked, and the lines placed from them
+  std::vector<std::string> GetSourceFiles() const;
+  const std::vector<DebugLine> &GetSourceLines() const;
+
+  void WriteToFile(const std::string &path) const;
+
+private:
+  struct Unit {
+    std::string path; // canonical, identifies the file
+    Module module;
+    std::vector<size_t> includes; // unit of each module include
+    bool cached = false;
+  };
+
+  LinkOptions options;
+  std::vector<Unit> units;
+  std::vector<uint8_t> bytes;
+  std::unordered_map<std::string, uint16_t> label_table;
+  std::vector<DebugLine> source_lines; // file is the unit index
+  Stats stats;
+
+  // ====== Stages ======
+  std::vector<size_t> load(const std::vector<std::string> &inputs);
+  Module load_module(const std::string &path, bool &cached) const;
+  void link(const std::vector<size_t> &roots);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef MODULE_4_CHIP8_HPP
+#define MODULE_4_CHIP8_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One assembled source file that has not been placed in memory yet. Label
+// references are kept as relocations, and labels are offsets into `bytes`.
+// A module can therefore be assembled once, cached, and linked anywhere.
+//
+// `.include` lines split a module into pieces. Piece k holds the bytes
+// between include k - 1 and include k, and the included module is placed
+// between them. Symbols record their piece because a label right before an
+// include has the same offset as the first byte after it.
+struct Module {
+  struct Symbol {
+    std::string name;
+    uint32_t offset;
+    uint32_t piece;
+  };
+
+  // the 12-bit address of the opcode at `offset` is `label`
+  struct Relocation {
+    std::string label;
+    uint32_t offset;
+    uint32_t piece;
+  };
+
+  struct Include {
+    std::string path; // as written, relative to the including file
+    uint32_t offset;
+  };
+
+  // a source line that assembled to bytes, for debug info
+  struct Line {
+    uint32_t offset;
+    uint32_t size;
+    uint32_t line; // 1-based line number in the source
+    uint32_t piece;
+  };
+
+  std::vector<uint8_t> bytes;
+  std::vector<Symbol> symbols;
+  std::vector<Relocation> relocations;
+  std::vector<Include> includes;
+  std::vector<Line> lines; // in offset order
+
+  // ====== Cache format ======
+  std::vector<uint8_t> Serialize() const;
+  // throws on data that was not written by Serialize()
+  static Module Deserialize(const std::vector<uint8_t> &data);
+};
+
+// cache key of a source file: 64-bit FNV-1a, seeded with the module format
+// version so a new encoder never reads stale modules
+uint64_t HashModuleSource(std::string_view source);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef OPTIMIZER_4_CHIP8_HPP
+#define OPTIMIZER_4_CHIP8_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../debug/debug_info.hpp"
+
+// Peephole pass over an assembled program (ch8asm -O). The source is
+// assembled once into a list of items, one per instruction or `.byte` line,
+// with label references kept symbolic. Passes then edit the list until none
+// applies:
+//
+//   - a JP or CALL to a JP goes straight to the final target
+//   - a JP to the next instruction is dropped
+//   - unlabelled instructions after an unconditional JP are dropped
+//   - an LD Vx whose value is overwritten by the next LD Vx is dropped, as
+//     are LD Vx, Vx and the second half of LD Vx, Vy / LD Vy, Vx
+//   - a labelled `.byte` block identical to an earlier one is dropped and
+//     its labels point at the earlier copy
+//
+// Labels of a dropped item move to the item after it, and every label
+// reference is resolved again from the new layout. Nothing that a skip
+// instruction (SE, SNE, SKP, SKNP) jumps over is dropped, since the skip
+// would then land somewhere else.
+//
+// Programs that jump, call or load I through a plain address into their
+// own image only get jump threading: moving code would break them. The
+// same holds for unreachable code in programs with a JP V0 table. Data
+// blocks are not merged in programs that index (ADD I) or write (LD [I],
+// LD B) through I, or where a block follows other data, since a read past
+// one label or a write to one copy would then reach the other.
+class Optimizer {
+public:
+  struct Stats {
+    size_t jumps_threaded = 0;
+    size_t instructions_removed = 0;
+    size_t blocks_merged = 0;
+    size_t bytes_saved = 0;
+  };
+
+  // throws on assembler errors; `.include` is not supported
+  explicit Optimizer(std::string_view source_code);
+
+  const std::vector<uint8_t> &GetBytes() const;
+  const std::unordered_map<std::string, uint16_t> &GetLabelTable() const;
+  const Stats &GetStats() const;
+  // for debug info, every line is in file 0
+  const std::vector<DebugLine> &GetSourceLines() const;
+
+  void WriteToFile(const std::string &path) const;
+
+private:
+  struct Item {
+    bool is_data = false; // a `.byte` line
+    uint16_t opcode = 0;  // address bits cleared when `target` is set
+    std::vector<uint8_t> data;
+    std::string target; // label in the 12-bit address, if any
+    std::vector<std::string> labels; // defined right before the item
+    uint32_t line = 0;               // in the source
+
+    size_t size() const { return is_data ? data.size() : 2; }
+  };
+
+  std::vector<Item> items;
+  // defined after the last item
+  std::vector<std::string> trailing_labels;
+
+  // an absolute address points into the image, so it must not move
+  bool fixed_layout = false;
+  bool has_jump_table = false;
+  bool indexes_data = false; // ADD I, or a store through I
+  // most bytes one DRW or LD Vx, [I] reads from I on
+  size_t longest_read = 0;
+
+  std::vector<uint8_t> bytes;
+  std::unordered_map<std::string, uint16_t> label_table;
+  std::vector<DebugLine> source_lines;
+  Stats stats;
+
+  // ====== Passes ======
+  bool thread_jumps();
+  bool remove_unreachable();
+  bool fold_loads();
+  bool merge_data_blocks();
+
+  // ====== Helpers ======
+  // label -> index of the item it names, items.size() past the end
+  std::unordered_map<std::string, size_t> label_items() const;
+  bool follows_skip(size_t i) const;
+  // labels move to the next item
+  void remove_item(size_t i);
+  // lays the items out and resolves every label reference
+  void emit();
+};
+
+#endif
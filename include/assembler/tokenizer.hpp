@@ -3,10 +3,13 @@
 
 #include <cctype>
 #include <cstddef>
+#include <cstdint>
 #include <string>
-#include <unordered_set>
+#include <string_view>
 #include <vector>
 
+#include "../utils/arena.hpp"
+
 enum class TokenType {
   LabelDef,
   Mnemonic,
@@ -18,64 +21,232 @@ enum class TokenType {
   SpecialMnemonic,
   MemoryDereference,
   ByteDirective,
+  IncludeDirective,
+  String, // "quoted", text excludes the quotes
   Unknown
 };
 
+enum class Mnemonic : uint8_t {
+  CLS,
+  RET,
+  JP,
+  CALL,
+  SE,
+  SNE,
+  LD,
+  ADD,
+  OR,
+  AND,
+  XOR,
+  SUB,
+  SUBN,
+  SHR,
+  SHL,
+  RND,
+  DRW,
+  SKP,
+  SKNP,
+  None
+};
+
+constexpr size_t MNEMONIC_COUNT = static_cast<size_t>(Mnemonic::None);
+
+enum class SpecialRegister : uint8_t { I, DT, ST };
+
+enum class SpecialMnemonic : uint8_t { F, B, K };
+
+// `text` points into the tokenizer's source buffer. `value` is resolved at
+// tokenization: the Mnemonic, SpecialRegister or SpecialMnemonic enum, or the
+// register number, depending on `type`.
 struct Token {
   TokenType type;
-  std::string text;
+  std::string_view text;
+  uint8_t value = 0;
 
   std::string as_string() const;
 };
 
-Token create_token(TokenType tt, std::string text);
-
-const std::unordered_set<std::string> CHIP8_MNEMONICS = {
-    "CLS", "RET", "JP",   "CALL", "SE",  "SNE", "LD",  "ADD", "OR",  "AND",
-    "XOR", "SUB", "SUBN", "SHR",  "SHL", "RND", "DRW", "SKP", "SKNP"};
-
-const std::unordered_set<std::string> SPECIAL_REGISTERS = {"I", "DT", "ST"};
-
-const std::unordered_set<std::string> SPECIAL_MNEMONICS = {"F", "B", "K"};
+Token create_token(TokenType tt, std::string_view text, uint8_t value = 0);
+
+// up to 4 characters packed into one integer, so a word can be matched with
+// a single switch over compile-time constants (a perfect hash)
+constexpr uint32_t pack_word(std::string_view s, bool ignore_case = false) {
+  if (s.size() > 4)
+    return 0;
+
+  uint32_t packed = 0;
+  for (char c : s) {
+    if (ignore_case && c >= 'a' && c <= 'z')
+      c = c - 'a' + 'A';
+    packed = (packed << 8) | static_cast<uint8_t>(c);
+  }
+  return packed;
+}
+
+// Mnemonic::None when `s` is not a mnemonic
+constexpr Mnemonic MnemonicFromText(std::string_view s,
+                                    bool ignore_case = false) {
+  switch (pack_word(s, ignore_case)) {
+  case pack_word("CLS"):
+    return Mnemonic::CLS;
+  case pack_word("RET"):
+    return Mnemonic::RET;
+  case pack_word("JP"):
+    return Mnemonic::JP;
+  case pack_word("CALL"):
+    return Mnemonic::CALL;
+  case pack_word("SE"):
+    return Mnemonic::SE;
+  case pack_word("SNE"):
+    return Mnemonic::SNE;
+  case pack_word("LD"):
+    return Mnemonic::LD;
+  case pack_word("ADD"):
+    return Mnemonic::ADD;
+  case pack_word("OR"):
+    return Mnemonic::OR;
+  case pack_word("AND"):
+    return Mnemonic::AND;
+  case pack_word("XOR"):
+    return Mnemonic::XOR;
+  case pack_word("SUB"):
+    return Mnemonic::SUB;
+  case pack_word("SUBN"):
+    return Mnemonic::SUBN;
+  case pack_word("SHR"):
+    return Mnemonic::SHR;
+  case pack_word("SHL"):
+    return Mnemonic::SHL;
+  case pack_word("RND"):
+    return Mnemonic::RND;
+  case pack_word("DRW"):
+    return Mnemonic::DRW;
+  case pack_word("SKP"):
+    return Mnemonic::SKP;
+  case pack_word("SKNP"):
+    return Mnemonic::SKNP;
+  default:
+    return Mnemonic::None;
+  }
+}
+
+// ====== Word classification ======
+// constexpr so the compile-time assembler classifies words exactly like the
+// tokenizer does
+
+constexpr bool IsHexDigit(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+         (c >= 'A' && c <= 'F');
+}
+
+constexpr uint8_t HexDigitValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return 10 + (c - 'a');
+  return 10 + (c - 'A');
+}
+
+constexpr bool IsImmediateWord(std::string_view s) {
+  if (s.substr(0, 2) == "0x")
+    return true;
+  for (char c : s) {
+    if (c < '0' || c > '9')
+      return false;
+  }
+  return true;
+}
+
+// `tokens_so_far` is the word's position in its line, only the first word
+// can define a label
+constexpr Token ClassifyWord(std::string_view st, size_t tokens_so_far) {
+  if (tokens_so_far == 0 && !st.empty() && st.back() == ':')
+    return {TokenType::LabelDef, st, 0};
+
+  const Mnemonic mnemonic = MnemonicFromText(st);
+  if (mnemonic != Mnemonic::None)
+    return {TokenType::Mnemonic, st, static_cast<uint8_t>(mnemonic)};
+
+  // registers: V0..VF
+  if (st.size() == 2 && st[0] == 'V' && IsHexDigit(st[1]))
+    return {TokenType::Register, st, HexDigitValue(st[1])};
+
+  switch (pack_word(st)) {
+  case pack_word(","):
+    return {TokenType::Comma, st, 0};
+  case pack_word("F"):
+    return {TokenType::SpecialMnemonic, st,
+            static_cast<uint8_t>(SpecialMnemonic::F)};
+  case pack_word("B"):
+    return {TokenType::SpecialMnemonic, st,
+            static_cast<uint8_t>(SpecialMnemonic::B)};
+  case pack_word("K"):
+    return {TokenType::SpecialMnemonic, st,
+            static_cast<uint8_t>(SpecialMnemonic::K)};
+  case pack_word("I"):
+    return {TokenType::SpecialRegister, st,
+            static_cast<uint8_t>(SpecialRegister::I)};
+  case pack_word("DT"):
+    return {TokenType::SpecialRegister, st,
+            static_cast<uint8_t>(SpecialRegister::DT)};
+  case pack_word("ST"):
+    return {TokenType::SpecialRegister, st,
+            static_cast<uint8_t>(SpecialRegister::ST)};
+  case pack_word("[I]"):
+    return {TokenType::MemoryDereference, st, 0};
+  default:
+    break;
+  }
+
+  if (st == ".byte")
+    return {TokenType::ByteDirective, st, 0};
+  if (st == ".include")
+    return {TokenType::IncludeDirective, st, 0};
+  if (st.size() >= 2 && st.front() == '"' && st.back() == '"')
+    return {TokenType::String, st.substr(1, st.size() - 2), 0};
+  if (IsImmediateWord(st))
+    return {TokenType::Immediate, st, 0};
+  return {TokenType::LabelRef, st, 0};
+}
+
+// tokens of one source line, stored in the tokenizer's arena
+struct TokenLine {
+  const Token *tokens = nullptr;
+  size_t count = 0;
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  // past the end reads an Unknown token, so parsers can match shapes
+  // without checking the length first
+  const Token &operator[](size_t i) const {
+    static const Token none = {TokenType::Unknown, {}, 0};
+    return i < count ? tokens[i] : none;
+  }
+  const Token &front() const { return tokens[0]; }
+  const Token &back() const { return tokens[count - 1]; }
+  const Token *begin() const { return tokens; }
+  const Token *end() const { return tokens + count; }
+};
 
+// Single pass over the source: words are split on whitespace and ',' (which
+// is a token of its own), ';' starts a comment. Tokens are views into one
+// owned copy of the source, nothing is allocated per token.
 class Tokenizer {
 
 private:
-  std::string source_code = {};
-  std::vector<std::string> source_code_lines = {};
-  std::vector<std::vector<Token>> token_lines = {};
-
-  // ====== Checkers ======
-  bool is_mnemonic(const std::string &s);
-  bool is_comma(const std::string &s);
-  bool is_immediate(const std::string &s);
-  bool is_register(const std::string &s);
-  bool is_labeldef(const std::string &s, size_t tokens_so_far);
-  bool is_special_register(const std::string &s);
-  bool is_memory_dereference(const std::string &s);
-  bool is_special_mnemonic(const std::string &s);
-  bool is_byte_directive(const std::string &s);
-
-  // strips away comment
-  std::string strip_comments(const std::string &line);
-
-  // adds gap between ','
-  std::string normalize(const std::string &line);
-
-  // splits up the line to individual string tokens
-  std::vector<std::string> generate_string_tokens(const std::string &line);
-  std::vector<Token> tokenize(const std::vector<std::string> &string_tokens);
-
-  // handles source code
-  void split_source_to_lines();
+  // heap buffer, stays put when the tokenizer is moved
+  std::vector<char> source_code = {};
+  Arena arena;
+  std::vector<TokenLine> token_lines = {};
 
   // generates token lines
   void generate_token_lines();
 
 public:
-  Tokenizer(std::string source);
+  Tokenizer(std::string_view source);
 
-  const std::vector<std::vector<Token>> &get_token_lines() const;
+  const std::vector<TokenLine> &get_token_lines() const;
 
   std::string get_tokens_lines_as_string() const;
 };
@@ -0,0 +1,35 @@
+#ifndef CHIP8_ASSETS_FONT_HPP
+#define CHIP8_ASSETS_FONT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "raylib.h"
+
+// Glyph atlas of fonts/scp-bold.ttf, rasterized at build time by ch8fontgen
+// into a generated source file. Only the alpha channel is stored.
+namespace EmbeddedFont {
+
+struct Glyph {
+  int value; // codepoint
+  int offset_x;
+  int offset_y;
+  int advance_x;
+  float x, y, width, height; // rectangle in the atlas
+};
+
+extern const int BASE_SIZE;
+extern const int GLYPH_PADDING;
+extern const int GLYPH_COUNT;
+extern const Glyph GLYPHS[];
+
+extern const int ATLAS_WIDTH;
+extern const int ATLAS_HEIGHT;
+extern const uint8_t ATLAS_ALPHA[];
+
+} // namespace EmbeddedFont
+
+// uploads the atlas and builds the glyph tables, free with UnloadFont()
+Font LoadEmbeddedFont();
+
+#endif
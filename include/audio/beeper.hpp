@@ -0,0 +1,66 @@
+#ifndef CHIP8_BEEPER_HPP
+#define CHIP8_BEEPER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "raylib.h"
+
+enum class BeeperWaveform { Square, Sine };
+
+// Procedural buzzer driven by a raylib AudioStream callback.
+//
+// The emulator schedules on/off transitions in sample time (relative to the
+// start of the current frame), the audio thread applies them at the exact
+// sample they fall on. Requires InitAudioDevice() to have been called.
+class Beeper {
+public:
+  static constexpr unsigned int SAMPLE_RATE = 44100;
+  static constexpr unsigned int BUFFER_FRAMES = 256; // ~5.8ms
+  static constexpr unsigned int SAMPLES_PER_FRAME = SAMPLE_RATE / 60;
+
+  Beeper(float frequency = 440.0f,
+         BeeperWaveform waveform = BeeperWaveform::Square);
+  ~Beeper();
+
+  Beeper(const Beeper &) = delete;
+  Beeper &operator=(const Beeper &) = delete;
+
+  // latches the sample position the current emulated frame maps onto
+  void BeginFrame();
+
+  // schedules a transition `offset` samples into the current frame
+  void Schedule(uint32_t offset, bool on);
+
+private:
+  // raylib callbacks carry no user pointer, only one beeper can be live
+  static Beeper *instance;
+  static void callback(void *buffer, unsigned int frames);
+
+  void render(int16_t *out, unsigned int frames);
+
+  AudioStream stream;
+  float frequency;
+  BeeperWaveform waveform;
+
+  // audio thread state
+  bool on = false;
+  double phase = 0.0;
+  std::atomic<uint64_t> sample_clock{0};
+
+  // emulator thread state
+  uint64_t frame_origin = 0;
+
+  // single producer (emulator) / single consumer (audio thread) queue
+  struct Event {
+    uint64_t sample;
+    bool on;
+  };
+  static constexpr size_t QUEUE_SIZE = 256;
+  Event queue[QUEUE_SIZE];
+  std::atomic<size_t> head{0};
+  std::atomic<size_t> tail{0};
+};
+
+#endif
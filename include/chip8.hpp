@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+#include "instruction.hpp"
+
 class Chip8 {
 public:
   // state
@@ -33,17 +35,46 @@ public:
   uint8_t delay{};
   uint8_t sound{};
 
+  // executed instruction count (used to timestamp events)
+  uint64_t cycles{};
+
+  // per instance RNG state (xorshift32) for Cxkk
+  uint32_t rng_state = 1;
+
+  // sound timer transitions (buzzer on/off), timestamped in cycles.
+  // the frontend drains this after every frame.
+  struct SoundEvent {
+    uint64_t cycle;
+    bool on;
+  };
+  static constexpr size_t SOUND_EVENTS_CAPACITY = 64;
+  SoundEvent sound_events[SOUND_EVENTS_CAPACITY]{};
+  size_t sound_events_count{};
+
   // video
   static constexpr uint8_t VIDEO_WIDTH = 64;
   static constexpr uint8_t VIDEO_HEIGHT = 32;
   uint8_t video[VIDEO_WIDTH * VIDEO_HEIGHT];
 
-  // opcode - current
+  // opcode - current, and its decoded form
   uint16_t opcode;
+  Instruction instruction{};
 
   // keypad
   uint8_t keypad[16]{};
 
+  // pending key transitions, applied right before the cycle they are stamped
+  // with. must be queued in cycle order.
+  struct KeyEvent {
+    uint64_t cycle;
+    uint8_t key;
+    bool down;
+  };
+  static constexpr size_t KEY_EVENTS_CAPACITY = 64;
+  KeyEvent key_events[KEY_EVENTS_CAPACITY]{};
+  size_t key_events_head{};
+  size_t key_events_count{};
+
   // rom
   std::vector<uint8_t> rom = {};
 
@@ -72,17 +103,40 @@ public:
   // member function pointer
   typedef void (Chip8::*Chip8OP)();
 
-  // decode tables
-  Chip8OP table[0xF + 1];
-  Chip8OP table0[0xF + 1]; // only requires 0xE + 1, just making it future proof
-  Chip8OP table8[0xF + 1]; // only requires 0xE + 1, but going OxF + 1 cause
-                           // it's safer and future proof
-  Chip8OP tableE[0xF + 1]; // only requires 0xE + 1, just making it future proof
-  Chip8OP tableF[0xFF + 1]; // adding HALT made it go till 0xFF + 1
+  // handler of every instruction kind
+  Chip8OP handlers[INSTRUCTION_KIND_COUNT];
+
+  // ====== Save states ======
+  // everything that changes while running, plain data so snapshots are a copy
+  struct State {
+    uint8_t memory[4096];
+    uint8_t V[16];
+    uint8_t sp;
+    uint16_t pc;
+    uint16_t index;
+    uint16_t stack[16];
+    uint8_t delay;
+    uint8_t sound;
+    uint64_t cycles;
+    uint32_t rng_state;
+    uint8_t video[VIDEO_WIDTH * VIDEO_HEIGHT];
+    uint16_t opcode;
+    uint8_t keypad[16];
+    bool halted;
+    KeyEvent key_events[KEY_EVENTS_CAPACITY];
+    size_t key_events_head;
+    size_t key_events_count;
+    SoundEvent sound_events[SOUND_EVENTS_CAPACITY];
+    size_t sound_events_count;
+  };
 
   // ====== Constructor ======
   Chip8();
 
+  // ====== Random ======
+  void Seed(uint32_t seed);
+  uint8_t NextRandomByte();
+
   // ====== Loaders ======
   void LoadFromArray(const uint8_t *rom, size_t size);
 
@@ -95,6 +149,25 @@ public:
   void Cycle();
   void UpdateTimers();
 
+  // runs one 60Hz frame: `cycles_per_frame` cycles, then a timer tick
+  void RunFrame(int cycles_per_frame);
+
+  // ====== Save states ======
+  void SaveState(State &state) const;
+  void LoadState(const State &state);
+
+  // ====== Input ======
+  void QueueKeyEvent(uint64_t cycle, uint8_t key, bool down);
+  void ApplyKeyEvents();
+
+  // ====== Sound ======
+  void SetSoundTimer(uint8_t value);
+  void PushSoundEvent(bool on);
+  void ClearSoundEvents() { sound_events_count = 0; }
+
+  // FxFF (HALT) stops the machine; without it FxFF is an unhandled opcode
+  void AllowCustomInstructions(bool allow);
+
   // ====== Debugging ======
   bool RunTillHalt();
   std::string DumpCPU() const;
@@ -102,15 +175,11 @@ public:
   std::string DumpRegisters() const;
   std::string DumpMemoryTableHex(uint16_t start, uint16_t count) const;
 
-  // ====== Opcode tables ======
-  void Table0() { (this->*(table0[(opcode & 0x000Fu)]))(); }
-  void Table8() { (this->*(table8[(opcode & 0x000Fu)]))(); }
-  void TableE() { (this->*(tableE[(opcode & 0x000Fu)]))(); }
-  void TableF() { (this->*(tableF[(opcode & 0x00FFu)]))(); }
-
   // ====== Opcodes ======
   void OP_NULL();
+  void OP_LOOSE();
 
+  void OP_0nnn();
   void OP_00E0();
   void OP_00EE();
 
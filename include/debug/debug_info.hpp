@@ -0,0 +1,92 @@
+#ifndef CHIP8_DEBUG_INFO_HPP
+#define CHIP8_DEBUG_INFO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../utils/mapped_file.hpp"
+
+// Source-level debug info for an assembled ROM, written by `ch8asm -g` next
+// to the ROM as `<rom>.dbg` and read by the ch8emu debugger.
+//
+// The file is laid out so it can be used straight from an mmap:
+//
+//   header    "C8DB", then u32 version, rom_size, line_count, symbol_count,
+//             file_count, strings_size, then u64 FNV-1a hash of the ROM
+//   index     u32 per ROM byte: 1 + the line covering it, 0 for none
+//   lines     7 x u32: address, size, file, line number, text offset,
+//             text length, 1 + symbol at address (0 for none)
+//   symbols   3 x u32: address, name offset, name length; by address
+//   files     2 x u32: path offset, path length
+//   strings   source text, symbol names and paths
+//
+// All integers are little endian, and lines are sorted by address.
+
+// one source line that assembled to bytes
+struct DebugLine {
+  uint16_t address;
+  uint16_t size;
+  uint32_t file; // into the file list
+  uint32_t line; // 1-based
+};
+
+// reads the line text back from `files`; a file that cannot be read leaves
+// its lines without text
+void WriteDebugInfo(const std::string &path, const std::vector<uint8_t> &rom,
+                    const std::vector<std::string> &files,
+                    std::vector<DebugLine> lines,
+                    const std::unordered_map<std::string, uint16_t> &symbols);
+
+class DebugInfo {
+public:
+  static constexpr size_t NO_LINE = static_cast<size_t>(-1);
+
+  struct Line {
+    uint16_t address;
+    uint16_t size;
+    uint32_t line;
+    std::string_view file;
+    std::string_view text;
+    std::string_view label; // defined at `address`, may be empty
+  };
+
+  // maps the file, throws when it is missing or malformed
+  explicit DebugInfo(const std::string &path);
+
+  // index of the line whose bytes cover addr, NO_LINE outside the ROM or
+  // between lines
+  size_t LineAt(uint16_t addr) const;
+  size_t LineCount() const { return line_count; }
+  Line GetLine(size_t index) const;
+
+  // the label at or before addr, empty before the first one
+  std::string_view LabelBefore(uint16_t addr) const;
+
+  // false when the file was written for a different ROM, e.g. one rebuilt
+  // since without -g
+  bool MatchesRom(const uint8_t *rom, size_t size) const;
+
+private:
+  MappedFile mapping;
+
+  uint32_t rom_size = 0;
+  uint64_t rom_hash = 0;
+  uint32_t line_count = 0;
+  uint32_t symbol_count = 0;
+  uint32_t file_count = 0;
+  const uint8_t *index = nullptr;
+  const uint8_t *lines = nullptr;
+  const uint8_t *symbols = nullptr;
+  const uint8_t *files = nullptr;
+  const char *strings = nullptr;
+  uint32_t strings_size = 0;
+
+  void validate() const;
+  std::string_view string_at(const uint8_t *record) const;
+};
+
+#endif
@@ -1,18 +1,54 @@
 #ifndef CHIP8_DISASSEMBLER_HPP
 #define CHIP8_DISASSEMBLER_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
 class Disassembler {
 
 public:
+  // room Decode needs in its buffer, and DecodeLine in its
+  static constexpr size_t MAX_DECODED_LENGTH = 24;
+  static constexpr size_t MAX_LINE_LENGTH = 64;
+
   static std::string Decode(uint16_t opcode);
-  static std::string DecodeRomFromArray(std::vector<uint8_t> rom,
+  static std::string DecodeRomFromArray(const std::vector<uint8_t> &rom,
                                         bool verbose = false);
   static std::vector<std::string>
-  DecodeRomFromArrayAsVector(std::vector<uint8_t> rom, bool verbose = false);
+  DecodeRomFromArrayAsVector(const std::vector<uint8_t> &rom,
+                             bool verbose = false);
+
+  // ====== Allocation-free decoding ======
+  // writes the text for opcode to out and returns its length, without a
+  // terminator. out holds at least MAX_DECODED_LENGTH chars.
+  static size_t Decode(uint16_t opcode, char *out);
+  // one listing line including its newline, prefixed with the address and
+  // opcode when verbose. out holds at least MAX_LINE_LENGTH chars.
+  static size_t DecodeLine(size_t address, uint16_t opcode, bool verbose,
+                           char *out);
+
+  // ====== Streaming ======
+  // the most of a listing held back before it is handed to the sink
+  static constexpr size_t STREAM_BUFFER_SIZE = 256 << 10;
+
+  // receives the listing in order, in chunks of whole lines
+  using Sink = std::function<void(const char *text, size_t length)>;
+
+  // the listing of size bytes at rom, as DecodeRomFromArray would build
+  // it. Memory use is the one buffer, whatever the size of the ROM.
+  static void DecodeRom(const uint8_t *rom, size_t size, bool verbose,
+                        const Sink &sink);
+
+  // Follows control flow from 0x200 (see FlowAnalysis) and lists what it
+  // reaches as instructions and everything else as .byte data, with labels
+  // for every jump, call and LD I target. The listing is ch8asm source that
+  // assembles back to the same bytes. Verbose adds the address and opcode
+  // of each line as a comment.
+  static void DecodeRomFollowingFlow(const uint8_t *rom, size_t size,
+                                     bool verbose, const Sink &sink);
 };
 
 #endif
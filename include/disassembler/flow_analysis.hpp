@@ -0,0 +1,73 @@
+#ifndef CHIP8_FLOW_ANALYSIS_HPP
+#define CHIP8_FLOW_ANALYSIS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Recursive-descent control flow over a ROM loaded at 0x200, the analysis
+// behind `ch8dis --flow`.
+//
+// Starting from 0x200 it follows JP and CALL targets, returns from RET and
+// both paths of every skip. JP V0, addr is an indirect branch whose targets
+// are unknown, so the path ends there. Bytes no path reaches are data, and
+// so is anything that does not decode to an instruction; where a path runs
+// into one is recorded as a stop.
+//
+// Every byte is visited at most once and all state lives in bitsets, so the
+// analysis is linear in the size of the ROM.
+class FlowAnalysis {
+public:
+  FlowAnalysis(const uint8_t *rom, size_t size);
+
+  // an instruction of the listing starts at offset. Two reached
+  // instructions can overlap; the first one wins and the other is data.
+  bool IsInstruction(size_t offset) const { return instruction.Test(offset); }
+  // something refers to offset and a listing line starts there
+  bool IsLabel(size_t offset) const { return label.Test(offset); }
+  bool IsCallTarget(size_t offset) const { return called.Test(offset); }
+
+  // the first instruction or label at or after offset, the size of the ROM
+  // when there is none
+  size_t NextInstruction(size_t offset) const {
+    return instruction.NextSet(offset, size);
+  }
+  size_t NextLabel(size_t offset) const { return label.NextSet(offset, size); }
+  // the first offset at or after offset where a path met SYS, ch8emu's
+  // HALT or an opcode outside the instruction set
+  size_t NextStop(size_t offset) const { return stop.NextSet(offset, size); }
+
+  size_t InstructionCount() const { return instruction_count; }
+  size_t IndirectJumpCount() const { return indirect_jumps; }
+
+private:
+  class Bitset {
+  public:
+    explicit Bitset(size_t size) : words((size + 63) / 64, 0) {}
+
+    bool Test(size_t i) const {
+      return i / 64 < words.size() && ((words[i / 64] >> (i % 64)) & 1u);
+    }
+    void Set(size_t i) { words[i / 64] |= uint64_t{1} << (i % 64); }
+    // the first set bit at or after i, `end` when there is none before it
+    size_t NextSet(size_t i, size_t end) const;
+
+  private:
+    std::vector<uint64_t> words;
+  };
+
+  size_t size;
+  Bitset reached;     // instructions some path executes
+  Bitset referenced;  // targets of JP, CALL and LD I inside the ROM
+  Bitset called;      // targets of CALL
+  Bitset instruction; // reached, minus those overlapping an earlier one
+  Bitset label;       // referenced, where a line of the listing starts
+  Bitset stop;        // opcodes that ended a path without executing
+  size_t instruction_count = 0;
+  size_t indirect_jumps = 0;
+
+  void follow(const uint8_t *rom);
+  void lay_out();
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef CHIP8_ROM_STATS_HPP
+#define CHIP8_ROM_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../instruction.hpp"
+
+// where an opcode that ends a path comes from
+enum class Extension : uint8_t {
+  SCHIP,        // 00Cn, 00FB-00FF, Fx30, Fx75, Fx85
+  XO_CHIP,      // 00Dn, 5xy2, 5xy3, F000, F002, Fn01, Fx3A
+  CH8EMU,       // FxFF, HALT
+  MACHINE_CODE, // any other 0nnn
+  UNKNOWN,
+};
+
+constexpr size_t EXTENSION_COUNT = static_cast<size_t>(Extension::UNKNOWN) + 1;
+
+// lowercase, as ch8scan reports it
+const char *ExtensionName(Extension extension);
+Extension ExtensionOf(uint16_t opcode);
+
+// What a ROM uses, from the code FlowAnalysis reaches: the figures
+// `ch8scan` reports to pick an emulator configuration.
+struct RomStats {
+  size_t size = 0;
+  size_t instruction_count = 0;
+  size_t code_bytes = 0; // bytes of reached instructions
+  // reached instructions of each kind, indexed by InstructionKind
+  uint32_t histogram[INSTRUCTION_KIND_COUNT]{};
+
+  // opcodes a path ran into and could not follow, see FlowAnalysis
+  struct Stop {
+    uint16_t address;
+    uint16_t opcode;
+  };
+  std::vector<Stop> stops;
+  uint32_t extensions[EXTENSION_COUNT]{}; // stops of each Extension
+
+  // ====== Quirks ======
+  // 8xy6 / 8xyE with y != 0: the VIP shifts Vy into Vx, CHIP-48 and SCHIP
+  // shift Vx. y == 0 is how assemblers write SHR Vx and y == x is the same
+  // either way, so neither is counted.
+  uint32_t shifts_reading_vy = 0;
+  // Dxy0: nothing on the VIP, a 16x16 sprite on SCHIP
+  uint32_t zero_height_draws = 0;
+
+  // Addresses of Fx55s that store over reached code. I is tracked from
+  // LD I, addr through straight-line code only; a store through an I that
+  // is not known there is not counted.
+  std::vector<uint16_t> self_modifying;
+
+  uint32_t Count(InstructionKind kind) const {
+    return histogram[static_cast<size_t>(kind)];
+  }
+  uint32_t Count(Extension extension) const {
+    return extensions[static_cast<size_t>(extension)];
+  }
+};
+
+// a ROM loaded at 0x200
+RomStats AnalyzeRom(const uint8_t *rom, size_t size);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CHIP8_HOT_RELOAD_HPP
+#define CHIP8_HOT_RELOAD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../assembler/incremental.hpp"
+#include "../chip8.hpp"
+#include "../utils/file_watcher.hpp"
+
+// Keeps a running machine in sync with its .chasm source. A reload
+// re-assembles the source in-process and patches only the bytes that differ
+// from the previous build into memory; registers, timers and the framebuffer
+// are left alone. When code moved, pc, the stack and I are carried along to
+// the same offset from their nearest label in the new layout.
+class HotReloader {
+public:
+  struct ReloadStats {
+    size_t bytes_patched = 0;
+    size_t regions = 0;    // contiguous runs of patched bytes
+    bool remapped = false; // the layout shifted, addresses were moved
+  };
+
+  // assembles the source once, throws on errors
+  explicit HotReloader(std::string source_path);
+
+  const std::string &SourcePath() const { return watcher.Path(); }
+  // the bytes currently loaded
+  const std::vector<uint8_t> &GetBytes() const { return loaded; }
+
+  // true when the source file was written since the last check
+  bool SourceChanged() { return watcher.Changed(); }
+
+  // throws on assembler errors, leaving `cpu` untouched
+  ReloadStats Reload(Chip8 &cpu);
+
+private:
+  FileWatcher watcher;
+
+  IncrementalAssembler assembler;
+  std::vector<uint8_t> loaded;
+  // labels of the loaded build, sorted by address
+  std::vector<std::pair<uint16_t, std::string>> labels;
+
+  void snapshot_labels();
+  uint16_t remap(uint16_t addr) const;
+};
+
+#endif
@@ -0,0 +1,296 @@
+#ifndef CHIP8_INSTRUCTION_HPP
+#define CHIP8_INSTRUCTION_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// The decoded form of a CHIP-8 opcode, shared by the emulator, the
+// disassembler and the assembler so all three agree on what every opcode
+// is. The kind of each of the 65536 opcodes is worked out once, at compile
+// time, into INSTRUCTION_KINDS; decoding is then a table lookup and a few
+// shifts.
+
+enum class InstructionKind : uint8_t {
+  CLS,        // 00E0
+  RET,        // 00EE
+  SYS,        // 0nnn
+  JP,         // 1nnn
+  CALL,       // 2nnn
+  SE_BYTE,    // 3xkk
+  SNE_BYTE,   // 4xkk
+  SE_REG,     // 5xy0
+  LD_BYTE,    // 6xkk
+  ADD_BYTE,   // 7xkk
+  LD_REG,     // 8xy0
+  OR,         // 8xy1
+  AND,        // 8xy2
+  XOR,        // 8xy3
+  ADD_REG,    // 8xy4
+  SUB,        // 8xy5
+  SHR,        // 8xy6
+  SUBN,       // 8xy7
+  SHL,        // 8xyE
+  SNE_REG,    // 9xy0
+  LD_I,       // Annn
+  JP_V0,      // Bnnn
+  RND,        // Cxkk
+  DRW,        // Dxyn
+  SKP,        // Ex9E
+  SKNP,       // ExA1
+  LD_FROM_DT, // Fx07
+  LD_KEY,     // Fx0A
+  LD_DT,      // Fx15
+  LD_ST,      // Fx18
+  ADD_I,      // Fx1E
+  LD_FONT,    // Fx29
+  LD_BCD,     // Fx33
+  STORE,      // Fx55
+  LOAD,       // Fx65
+  HALT,       // FxFF, ch8emu's own
+  UNKNOWN,
+};
+
+constexpr size_t INSTRUCTION_KIND_COUNT =
+    static_cast<size_t>(InstructionKind::UNKNOWN) + 1;
+
+// every field is filled whatever the kind uses
+struct Instruction {
+  InstructionKind kind;
+  uint8_t x;
+  uint8_t y;
+  uint8_t n;
+  uint8_t kk;
+  uint16_t nnn;
+  uint16_t opcode;
+};
+
+// ====== Decoding ======
+// the kind of one opcode, straight from its bits
+constexpr InstructionKind ClassifyOpcode(uint16_t opcode) {
+  using K = InstructionKind;
+  const uint8_t n = opcode & 0x000Fu;
+  const uint8_t kk = opcode & 0x00FFu;
+
+  switch ((opcode & 0xF000u) >> 12u) {
+  case 0x0:
+    return opcode == 0x00E0 ? K::CLS : opcode == 0x00EE ? K::RET : K::SYS;
+  case 0x1:
+    return K::JP;
+  case 0x2:
+    return K::CALL;
+  case 0x3:
+    return K::SE_BYTE;
+  case 0x4:
+    return K::SNE_BYTE;
+  case 0x5:
+    return n == 0x0 ? K::SE_REG : K::UNKNOWN;
+  case 0x6:
+    return K::LD_BYTE;
+  case 0x7:
+    return K::ADD_BYTE;
+  case 0x8:
+    switch (n) {
+    case 0x0:
+      return K::LD_REG;
+    case 0x1:
+      return K::OR;
+    case 0x2:
+      return K::AND;
+    case 0x3:
+      return K::XOR;
+    case 0x4:
+      return K::ADD_REG;
+    case 0x5:
+      return K::SUB;
+    case 0x6:
+      return K::SHR;
+    case 0x7:
+      return K::SUBN;
+    case 0xE:
+      return K::SHL;
+    default:
+      return K::UNKNOWN;
+    }
+  case 0x9:
+    return n == 0x0 ? K::SNE_REG : K::UNKNOWN;
+  case 0xA:
+    return K::LD_I;
+  case 0xB:
+    return K::JP_V0;
+  case 0xC:
+    return K::RND;
+  case 0xD:
+    return K::DRW;
+  case 0xE:
+    return kk == 0x9E ? K::SKP : kk == 0xA1 ? K::SKNP : K::UNKNOWN;
+  default:
+    switch (kk) {
+    case 0x07:
+      return K::LD_FROM_DT;
+    case 0x0A:
+      return K::LD_KEY;
+    case 0x15:
+      return K::LD_DT;
+    case 0x18:
+      return K::LD_ST;
+    case 0x1E:
+      return K::ADD_I;
+    case 0x29:
+      return K::LD_FONT;
+    case 0x33:
+      return K::LD_BCD;
+    case 0x55:
+      return K::STORE;
+    case 0x65:
+      return K::LOAD;
+    case 0xFF:
+      return K::HALT;
+    default:
+      return K::UNKNOWN;
+    }
+  }
+}
+
+// Outside 0nnn the kind depends only on the first nibble and the low byte,
+// so each of those 4096 pairs is classified once and copied to the 16
+// opcodes that share it; that keeps the compile-time work small.
+constexpr std::array<InstructionKind, 0x10000> MakeInstructionKinds() {
+  std::array<InstructionKind, 0x10000> kinds{};
+  for (uint32_t first = 0x0; first <= 0xF; first += 1) {
+    for (uint32_t kk = 0x00; kk <= 0xFF; kk += 1) {
+      const InstructionKind kind =
+          ClassifyOpcode(static_cast<uint16_t>((first << 12u) | kk));
+      for (uint32_t x = 0x0; x <= 0xF; x += 1)
+        kinds[(first << 12u) | (x << 8u) | kk] = kind;
+    }
+  }
+  // SYS is the only form that looks at x
+  for (uint32_t opcode = 0x0100; opcode <= 0x0FFF; opcode += 1)
+    kinds[opcode] = InstructionKind::SYS;
+  return kinds;
+}
+
+inline constexpr std::array<InstructionKind, 0x10000> INSTRUCTION_KINDS =
+    MakeInstructionKinds();
+
+constexpr Instruction DecodeInstruction(uint16_t opcode) {
+  return {INSTRUCTION_KINDS[opcode],
+          static_cast<uint8_t>((opcode & 0x0F00u) >> 8u),
+          static_cast<uint8_t>((opcode & 0x00F0u) >> 4u),
+          static_cast<uint8_t>(opcode & 0x000Fu),
+          static_cast<uint8_t>(opcode & 0x00FFu),
+          static_cast<uint16_t>(opcode & 0x0FFFu),
+          opcode};
+}
+
+// `count` big-endian opcodes from `bytes` into `out`
+void DecodeInstructions(const uint8_t *bytes, size_t count, Instruction *out);
+
+// ====== Encoding ======
+// the operands a form carries besides its fixed bits
+enum class OperandLayout : uint8_t { NONE, X, X_Y, X_KK, NNN, X_Y_N };
+
+struct InstructionForm {
+  uint16_t base; // the opcode with every operand 0
+  OperandLayout layout;
+  const char *pattern; // as CHIP-8 references write it, "8xy4"
+};
+
+// indexed by InstructionKind
+inline constexpr InstructionForm INSTRUCTION_FORMS[INSTRUCTION_KIND_COUNT] = {
+    {0x00E0, OperandLayout::NONE, "00E0"},  // CLS
+    {0x00EE, OperandLayout::NONE, "00EE"},  // RET
+    {0x0000, OperandLayout::NNN, "0nnn"},   // SYS
+    {0x1000, OperandLayout::NNN, "1nnn"},   // JP
+    {0x2000, OperandLayout::NNN, "2nnn"},   // CALL
+    {0x3000, OperandLayout::X_KK, "3xkk"},  // SE_BYTE
+    {0x4000, OperandLayout::X_KK, "4xkk"},  // SNE_BYTE
+    {0x5000, OperandLayout::X_Y, "5xy0"},   // SE_REG
+    {0x6000, OperandLayout::X_KK, "6xkk"},  // LD_BYTE
+    {0x7000, OperandLayout::X_KK, "7xkk"},  // ADD_BYTE
+    {0x8000, OperandLayout::X_Y, "8xy0"},   // LD_REG
+    {0x8001, OperandLayout::X_Y, "8xy1"},   // OR
+    {0x8002, OperandLayout::X_Y, "8xy2"},   // AND
+    {0x8003, OperandLayout::X_Y, "8xy3"},   // XOR
+    {0x8004, OperandLayout::X_Y, "8xy4"},   // ADD_REG
+    {0x8005, OperandLayout::X_Y, "8xy5"},   // SUB
+    {0x8006, OperandLayout::X_Y, "8xy6"},   // SHR
+    {0x8007, OperandLayout::X_Y, "8xy7"},   // SUBN
+    {0x800E, OperandLayout::X_Y, "8xyE"},   // SHL
+    {0x9000, OperandLayout::X_Y, "9xy0"},   // SNE_REG
+    {0xA000, OperandLayout::NNN, "Annn"},   // LD_I
+    {0xB000, OperandLayout::NNN, "Bnnn"},   // JP_V0
+    {0xC000, OperandLayout::X_KK, "Cxkk"},  // RND
+    {0xD000, OperandLayout::X_Y_N, "Dxyn"}, // DRW
+    {0xE09E, OperandLayout::X, "Ex9E"},     // SKP
+    {0xE0A1, OperandLayout::X, "ExA1"},     // SKNP
+    {0xF007, OperandLayout::X, "Fx07"},     // LD_FROM_DT
+    {0xF00A, OperandLayout::X, "Fx0A"},     // LD_KEY
+    {0xF015, OperandLayout::X, "Fx15"},     // LD_DT
+    {0xF018, OperandLayout::X, "Fx18"},     // LD_ST
+    {0xF01E, OperandLayout::X, "Fx1E"},     // ADD_I
+    {0xF029, OperandLayout::X, "Fx29"},     // LD_FONT
+    {0xF033, OperandLayout::X, "Fx33"},     // LD_BCD
+    {0xF055, OperandLayout::X, "Fx55"},     // STORE
+    {0xF065, OperandLayout::X, "Fx65"},     // LOAD
+    {0xF0FF, OperandLayout::X, "FxFF"},     // HALT
+    {0x0000, OperandLayout::NONE, "????"},  // UNKNOWN
+};
+
+// the opcode of `kind` from x, y and its last operand (n, kk or nnn), each
+// masked to its field; operands the form does not have are ignored
+constexpr uint16_t EncodeInstruction(InstructionKind kind, uint8_t x = 0,
+                                     uint8_t y = 0, uint16_t operand = 0) {
+  const InstructionForm form = INSTRUCTION_FORMS[static_cast<size_t>(kind)];
+  const uint16_t vx = (x & 0xFu) << 8u;
+  const uint16_t vy = (y & 0xFu) << 4u;
+
+  switch (form.layout) {
+  case OperandLayout::X:
+    return form.base | vx;
+  case OperandLayout::X_Y:
+    return form.base | vx | vy;
+  case OperandLayout::X_KK:
+    return form.base | vx | (operand & 0x00FFu);
+  case OperandLayout::NNN:
+    return form.base | (operand & 0x0FFFu);
+  case OperandLayout::X_Y_N:
+    return form.base | vx | vy | (operand & 0x000Fu);
+  default:
+    return form.base;
+  }
+}
+
+// the opcode back; an unknown instruction keeps the one it came from
+constexpr uint16_t EncodeInstruction(const Instruction &instruction) {
+  switch (INSTRUCTION_FORMS[static_cast<size_t>(instruction.kind)].layout) {
+  case OperandLayout::X_KK:
+    return EncodeInstruction(instruction.kind, instruction.x, 0,
+                             instruction.kk);
+  case OperandLayout::NNN:
+    return EncodeInstruction(instruction.kind, 0, 0, instruction.nnn);
+  default:
+    return instruction.kind == InstructionKind::UNKNOWN
+               ? instruction.opcode
+               : EncodeInstruction(instruction.kind, instruction.x,
+                                   instruction.y, instruction.n);
+  }
+}
+
+// ====== Properties ======
+// skips the next instruction when its condition holds
+constexpr bool IsSkip(InstructionKind kind) {
+  using K = InstructionKind;
+  return kind == K::SE_BYTE || kind == K::SNE_BYTE || kind == K::SE_REG ||
+         kind == K::SNE_REG || kind == K::SKP || kind == K::SKNP;
+}
+
+// the low 12 bits are an address
+constexpr bool HasAddress(InstructionKind kind) {
+  using K = InstructionKind;
+  return kind == K::JP || kind == K::CALL || kind == K::LD_I ||
+         kind == K::JP_V0;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef CHIP8_ARENA_HPP
+#define CHIP8_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator. Memory is handed out from large blocks and released all at
+// once when the arena dies, nothing is ever freed individually. Blocks never
+// move, so pointers stay valid when the arena itself is moved.
+class Arena {
+public:
+  explicit Arena(size_t block_size = 64 * 1024);
+
+  Arena(Arena &&) = default;
+  Arena &operator=(Arena &&) = default;
+
+  void *Allocate(size_t size, size_t alignment);
+
+  // only for types that need no destructor
+  template <typename T> T *AllocateArray(size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "arena memory is never destructed");
+    return static_cast<T *>(Allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  size_t BytesUsed() const { return used; }
+
+private:
+  size_t block_size;
+  std::vector<std::unique_ptr<uint8_t[]>> blocks;
+  uint8_t *cursor = nullptr;
+  size_t remaining = 0;
+  size_t used = 0;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef CHIP8_ARTIFACT_CACHE_HPP
+#define CHIP8_ARTIFACT_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "mapped_file.hpp"
+
+// Content-addressed store of build outputs, the --cache-dir of ch8asm and
+// ch8dis. An entry is a file named after its key and an extension; the key
+// hashes everything the output depends on (tool, version, flags, input).
+//
+// Entries are written to a temporary file and renamed into place, so a
+// reader never sees half an entry and racing writers of one key are
+// harmless. The modification time of an entry is its last use: hits touch
+// it, and once the directory outgrows its bound the least recently used
+// entries are deleted. Only entry names count towards the bound, other files
+// in the directory are left alone.
+class ArtifactCache {
+public:
+  static constexpr uint64_t DEFAULT_MAX_BYTES = 64ull << 20;
+
+  // 64-bit FNV-1a over every part, each prefixed with its length
+  static uint64_t Key(std::initializer_list<std::string_view> parts);
+
+  explicit ArtifactCache(std::string dir,
+                         uint64_t max_bytes = DEFAULT_MAX_BYTES);
+
+  // ====== Lookups ======
+  // both count as a use of the entry
+  std::optional<MappedFile> Map(uint64_t key, std::string_view extension);
+  // shares the blocks of the entry where the file system can (reflink),
+  // copies otherwise. false on a miss.
+  bool CopyTo(uint64_t key, std::string_view extension,
+              const std::string &path);
+
+  // ====== Writes ======
+  // best effort, a failed write only leaves the entry out
+  void Store(uint64_t key, std::string_view extension, const void *data,
+             size_t size);
+
+private:
+  std::string dir;
+  uint64_t max_bytes;
+
+  // bytes in the directory, counted on the first store
+  std::mutex mutex;
+  bool scanned = false;
+  uint64_t total_bytes = 0;
+
+  std::string entry_path(uint64_t key, std::string_view extension) const;
+  static void touch(const std::string &path);
+  void evict();
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef CHIP8_BATCH_HPP
+#define CHIP8_BATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Shared driver of `ch8asm --batch` and `ch8dis --batch`: many files through
+// one tool in one process, spread over a thread pool.
+
+struct BatchReport {
+  size_t files = 0;
+  size_t failed = 0;
+  uint64_t bytes_in = 0;
+  uint64_t bytes_out = 0;
+  double seconds = 0;
+};
+
+// what one job read and wrote
+struct BatchJobResult {
+  uint64_t bytes_in = 0;
+  uint64_t bytes_out = 0;
+};
+
+// Paths as given, globs with '*' and '?' in the file name (matches are
+// sorted), and "-" for a manifest on stdin with one path or glob per line.
+// A file named twice is kept once, where it first appears. Throws when a
+// glob's directory cannot be read.
+std::vector<std::string> ExpandInputs(const std::vector<std::string> &args);
+
+// drops later paths naming a file already in `paths`
+void RemoveDuplicateInputs(std::vector<std::string> &paths);
+
+// `input` with its extension replaced, in `out_dir` unless that is empty
+std::string BatchOutputPath(const std::string &input,
+                            const std::string &out_dir,
+                            const std::string &extension);
+
+// BatchOutputPath of every input, in order. Throws, naming both inputs,
+// when two of them would write the same file.
+std::vector<std::string>
+BatchOutputPaths(const std::vector<std::string> &inputs,
+                 const std::string &out_dir, const std::string &extension);
+
+// Runs `job` on every input, `threads` at a time (0 uses every core). A job
+// reports failure by throwing; the batch goes on and the errors are printed
+// to stderr in input order once all jobs are done. `job` is handed the
+// elements of `inputs` themselves, so `&input - inputs.data()` is the index.
+BatchReport
+RunBatch(const std::vector<std::string> &inputs, size_t threads,
+         const std::function<BatchJobResult(const std::string &)> &job);
+
+// "<files> files (<failed> failed), <in> bytes in, <out> bytes out in <ms>
+// ms, <MB/s> MB/s"
+void PrintBatchReport(std::ostream &out, const BatchReport &report);
+
+// the whole buffer in one write
+void WriteWholeFile(const std::string &path, const void *data, size_t size);
+
+#endif
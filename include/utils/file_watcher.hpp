@@ -0,0 +1,51 @@
+#ifndef CHIP8_FILE_WATCHER_HPP
+#define CHIP8_FILE_WATCHER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Notices when a file is written, for ch8asm --watch and the emulator's hot
+// reload. On Linux inotify watches the directory
+// the file lives in, so saves that replace the file by renaming are seen as
+// well, and nothing is checked until an event arrives. Elsewhere, or when
+// inotify is not available, the modification time and size are polled
+// every POLL_INTERVAL.
+class FileWatcher {
+public:
+  static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(50);
+
+  explicit FileWatcher(std::string path);
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  const std::string &Path() const { return path; }
+
+  // true when the file was written since the last call, and on the first
+  // call that finds the file. never blocks.
+  bool Changed();
+
+  // blocks until Changed() may have something new
+  void Wait();
+
+private:
+  std::string path;
+  std::filesystem::file_time_type last_write{};
+  uintmax_t last_size = 0;
+  bool seen = false;
+
+  int inotify_fd = -1; // -1 when polling
+  std::string name;    // of the file, as inotify reports it
+  bool pending = true; // an event since the file was last checked
+  std::chrono::steady_clock::time_point last_poll{};
+
+  void read_events();
+};
+
+// the whole file, throws when it cannot be opened
+std::string ReadSource(const std::string &path);
+
+#endif
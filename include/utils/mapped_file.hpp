@@ -0,0 +1,34 @@
+#ifndef CHIP8_MAPPED_FILE_HPP
+#define CHIP8_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A whole file, read-only. Mapped with mmap where available and read into
+// memory elsewhere. Empty files have size() == 0 and a null data().
+class MappedFile {
+public:
+  // throws when the file cannot be opened
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const uint8_t *data() const { return bytes; }
+  size_t size() const { return length; }
+
+private:
+  const uint8_t *bytes = nullptr;
+  size_t length = 0;
+  bool mapped = false;
+  std::vector<uint8_t> buffer; // where mmap is not available
+
+  void release();
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef CHIP8_PARSE_COUNT_HPP
+#define CHIP8_PARSE_COUNT_HPP
+
+#include <cstdint>
+#include <string_view>
+
+// upper bound of --threads in the command line tools
+constexpr uint64_t MAX_THREAD_COUNT = 1024;
+
+// Reads a command line count: decimal digits only, nothing before or after
+// them, at most `max`. std::stoul alone takes "-1" as a huge count and
+// "12abc" as 12, and throws on text that is not a number. Returns false and
+// leaves `count` untouched when `text` is not such a count.
+bool ParseCount(std::string_view text, uint64_t max, uint64_t &count);
+
+#endif
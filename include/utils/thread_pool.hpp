@@ -0,0 +1,53 @@
+#ifndef CHIP8_THREAD_POOL_HPP
+#define CHIP8_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running one parallel loop at a time.
+//
+// ParallelFor blocks until every index has been processed. Work is handed
+// out through an atomic counter, the calling thread helps as well. The first
+// exception thrown by `fn` is rethrown on the calling thread.
+class ThreadPool {
+public:
+  // 0 uses std::thread::hardware_concurrency()
+  explicit ThreadPool(size_t thread_count = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void ParallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+  size_t ThreadCount() const { return workers.size() + 1; }
+
+private:
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable work_ready;
+  std::condition_variable work_done;
+
+  // current job
+  const std::function<void(size_t)> *job = nullptr;
+  size_t job_count = 0;
+  std::atomic<size_t> next_index{0};
+  size_t generation = 0;
+  size_t busy_workers = 0;
+  std::exception_ptr error;
+  bool stopping = false;
+
+  // wakes and joins every worker
+  void stop();
+  void worker_loop();
+  void run_job(const std::function<void(size_t)> &fn, size_t count);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef CHIP8_FRAME_WRITER_HPP
+#define CHIP8_FRAME_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// raw: packed 1-bit rows (MSB = leftmost pixel), no header
+// ppm: one binary P6 image per frame (ffmpeg: -f image2pipe -c:v ppm)
+// y4m: YUV4MPEG2 stream, 4:2:0 with neutral chroma
+enum class FrameFormat { Raw, PPM, Y4M };
+
+FrameFormat ParseFrameFormat(const std::string &format);
+
+// Streams 1 byte-per-pixel (0/1) framebuffers, as found in Chip8::video.
+class FrameWriter {
+public:
+  FrameWriter(std::ostream &out, FrameFormat format, size_t width,
+              size_t height, unsigned int fps = 60, size_t scale = 1);
+
+  void WriteFrame(const uint8_t *video);
+
+  size_t FramesWritten() const { return frames_written; }
+
+private:
+  std::ostream &out;
+  FrameFormat format;
+  size_t width;
+  size_t height;
+  unsigned int fps;
+  size_t scale;
+
+  size_t frames_written = 0;
+
+  // reused for every frame, sized once
+  std::vector<uint8_t> buffer;
+
+  void write_header();
+  void pack_bits(const uint8_t *video);
+  void scale_luma(const uint8_t *video, uint8_t *dst, size_t channels);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef CHIP8_RECORDER_HPP
+#define CHIP8_RECORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Keeps the last N frames of play in memory, cheap enough to run every frame.
+//
+// Each frame is packed to 1 bit per pixel, XORed against the previous frame
+// and run-length encoded (mostly zero bytes between consecutive frames).
+// Buzzer transitions are stored alongside, as sample offsets into the frame.
+// The oldest frame is folded into a base image when it gets evicted, so the
+// ring never needs keyframes. A copy is a few KB per second of play, so
+// Dump can run on a copy while capture goes on.
+class Recorder {
+public:
+  static constexpr unsigned int FPS = 60;
+  static constexpr unsigned int SAMPLE_RATE = 44100;
+  static constexpr unsigned int SAMPLES_PER_FRAME = SAMPLE_RATE / FPS;
+
+  struct AudioEvent {
+    uint16_t offset; // samples into the frame, < SAMPLES_PER_FRAME
+    bool on;
+  };
+
+  Recorder(size_t width, size_t height, size_t capacity);
+
+  // records one frame, `video` is 1 byte per pixel (0/1)
+  void Capture(const uint8_t *video, const AudioEvent *events,
+               size_t event_count);
+
+  // writes <basename>.y4m and <basename>.wav, returns frames written
+  size_t Dump(const std::string &basename, size_t scale = 8) const;
+
+  size_t Size() const { return count; }
+  size_t Capacity() const { return slots.size(); }
+
+private:
+  struct Slot {
+    std::vector<uint8_t> delta; // RLE of (frame ^ previous), capacity reused
+    std::vector<AudioEvent> events;
+  };
+
+  size_t width;
+  size_t height;
+  size_t packed_size;
+
+  std::vector<Slot> slots;
+  size_t head = 0; // next slot to write
+  size_t count = 0;
+
+  // state right before the oldest frame in the ring
+  std::vector<uint8_t> base_frame;
+  bool base_sound = false;
+
+  // state after the newest frame
+  std::vector<uint8_t> last_frame;
+  std::vector<uint8_t> scratch;
+
+  void pack(const uint8_t *video, uint8_t *dst) const;
+  void unpack(const uint8_t *src, uint8_t *video) const;
+
+  static void encode(const uint8_t *current, const uint8_t *previous,
+                     size_t size, std::vector<uint8_t> &out);
+  static void apply(const std::vector<uint8_t> &delta, uint8_t *frame);
+};
+
+#endif
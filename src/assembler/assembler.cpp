@@ -7,48 +7,103 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "../../include/assembler/assembler.hpp"
+#include "../../include/instruction.hpp"
 
 // ====== Stages ======
-void Assembler::run_first_pass() {
-  uint16_t PC = 0x200;
-  for (const auto &line : tkzr.get_token_lines()) {
+void Assembler::define_label(std::string_view label, uint16_t PC) {
+  if (label_table.find(label) != label_table.end()) {
+    std::cerr << "error: duplicate label: " << label << "\n";
+  } else {
+    label_table[label] = PC;
+  }
+}
 
-    if (line.empty())
-      continue;
+void Assembler::resolve_fixups() {
+  for (const auto &fixup : fixups) {
+    const auto it = label_table.find(fixup.label);
+    if (it == label_table.end()) {
+      std::ostringstream oss;
+      oss << "error: unknown label: " << fixup.label;
+      throw std::runtime_error(oss.str());
+    }
 
-    size_t start = 0;
+    // the opcode was emitted with nnn = 0
+    const uint16_t addr = AddressOperand(fixup.label, it->second);
+    bytes[fixup.offset] |= (addr >> 8u);
+    bytes[fixup.offset + 1] |= (addr & 0x00FFu);
+  }
+  fixups.clear();
+}
 
-    if (line.front().type == TokenType::LabelDef) {
-      const std::string label =
-          line.front().text.substr(0, line.front().text.size() - 1);
+uint16_t Assembler::AddressOperand(std::string_view label, uint32_t addr) {
+  if (addr > 0xFFF) {
+    std::ostringstream oss;
+    oss << "label address out of range ( <= 0xFFF): " << label << " = 0x"
+        << std::hex << addr;
+    throw std::runtime_error(oss.str());
+  }
+  return static_cast<uint16_t>(addr);
+}
 
-      if (label_table.find(label) != label_table.end()) {
-        std::cerr << "error: duplicate label: " << label << "\n";
-      } else {
-        label_table[label] = PC;
-      }
+// ====== Lines ======
+const char *const Assembler::INCLUDE_NEEDS_FILE =
+    ".include needs a file to resolve against, assemble with ch8asm";
 
-      start = 1;
-      if (line.size() == 1)
-        continue; // only label
-    }
+std::string_view Assembler::label_name(const TokenLine &line) {
+  std::string_view label = line.front().text;
+  label.remove_suffix(1); // ':'
+  return label;
+}
 
-    if (line[start].type == TokenType::ByteDirective) {
-      size_t byte_count = 0;
-      for (const auto &tk : line) {
-        if (tk.type == TokenType::Immediate)
-          byte_count += 1;
-      }
+size_t Assembler::body_start(const TokenLine &line) {
+  return !line.empty() && line.front().type == TokenType::LabelDef ? 1 : 0;
+}
+
+bool Assembler::is_include(const TokenLine &line) {
+  return line[body_start(line)].type == TokenType::IncludeDirective;
+}
 
-      PC += byte_count;
-    } else {
+size_t Assembler::line_size(const TokenLine &line) {
+  const size_t start = body_start(line);
+  if (start == line.size() || is_include(line))
+    return 0;
 
-      PC += 2;
+  if (line[start].type != TokenType::ByteDirective)
+    return 2;
+
+  size_t byte_count = 0;
+  for (size_t i = start + 1; i < line.size(); i += 1) {
+    if (line[i].type == TokenType::Immediate)
+      byte_count += 1;
+  }
+  return byte_count;
+}
+
+void Assembler::encode_line(const TokenLine &line, size_t offset) {
+  const size_t start = body_start(line);
+
+  if (line[start].type == TokenType::ByteDirective) {
+    for (size_t i = start + 1; i < line.size(); i += 1) {
+      if (line[i].type == TokenType::Immediate) {
+        uint16_t val = parse_immediate(line[i].text);
+
+        if (val > 0xFF)
+          throw std::runtime_error("immediate value out of range for a byte");
+        bytes[offset++] = val;
+      }
     }
+  } else {
+    encode_offset = offset;
+    uint16_t opcode = assemble_instruction(line);
+
+    bytes[offset] = (opcode & 0xFF00u) >> 8u;
+    bytes[offset + 1] = opcode & 0x00FFu;
   }
 }
 
@@ -57,8 +112,18 @@ bool Assembler::is_immediate_or_label(const Token &tk) {
   return tk.type == TokenType::Immediate || tk.type == TokenType::LabelRef;
 }
 
+bool Assembler::is_special_register(const Token &tk, SpecialRegister reg) {
+  return tk.type == TokenType::SpecialRegister &&
+         tk.value == static_cast<uint8_t>(reg);
+}
+
+bool Assembler::is_special_mnemonic(const Token &tk, SpecialMnemonic sm) {
+  return tk.type == TokenType::SpecialMnemonic &&
+         tk.value == static_cast<uint8_t>(sm);
+}
+
 // ====== Parsing helpers ======
-void print_token_line(const std::vector<Token> &line) {
+void print_token_line(const TokenLine &line) {
   for (const auto &token : line) {
     std::cout << token.as_string();
   }
@@ -66,7 +131,7 @@ void print_token_line(const std::vector<Token> &line) {
 }
 
 void Assembler::throw_invalid_instruction(
-    const char *MNEMONIC, const std::vector<Token> &line) const {
+    const char *MNEMONIC, const TokenLine &line) const {
   std::ostringstream oss;
   oss << "invalid " << MNEMONIC << " instruction: ";
   for (const auto &tk : line)
@@ -74,257 +139,275 @@ void Assembler::throw_invalid_instruction(
   throw std::runtime_error(oss.str());
 }
 
-uint16_t Assembler::parse_immediate(const std::string &s) {
-  // hex
-  if (s.rfind("0x", 0) == 0 || s.rfind("0X", 0) == 0)
-    return std::stoul(s, nullptr, 16);
-  // decimal
-  return std::stoul(s, nullptr, 10);
+uint16_t Assembler::parse_immediate(std::string_view s) {
+  const bool hex = s.substr(0, 2) == "0x" || s.substr(0, 2) == "0X";
+  if (hex)
+    s.remove_prefix(2);
+
+  // digits up to the first invalid character, like std::stoul
+  uint32_t value = 0;
+  size_t digits = 0;
+  for (char c : s) {
+    uint32_t digit;
+    if (c >= '0' && c <= '9')
+      digit = c - '0';
+    else if (hex && c >= 'a' && c <= 'f')
+      digit = 10 + (c - 'a');
+    else if (hex && c >= 'A' && c <= 'F')
+      digit = 10 + (c - 'A');
+    else
+      break;
+
+    value = value * (hex ? 16 : 10) + digit;
+    if (value > 0xFFFF)
+      throw std::runtime_error("immediate value out of range: " +
+                               std::string(s));
+    digits += 1;
+  }
+
+  if (digits == 0)
+    throw std::runtime_error("invalid immediate value: " + std::string(s));
+
+  return value;
 }
 
-uint8_t Assembler::parse_register(const std::string &s) {
-  if (s.size() != 2 || s[0] != 'V')
-    throw std::runtime_error("invalid register name: " + s);
+uint8_t Assembler::parse_register(const Token &tk) {
+  // the register number was resolved by the tokenizer
+  if (tk.type != TokenType::Register)
+    throw std::runtime_error("invalid register name: " + std::string(tk.text));
 
-  char reg = std::toupper(s[1]);
-
-  if (reg >= '0' && reg <= '9')
-    return reg - '0';
-  if (reg >= 'A' && reg <= 'F')
-    return 10 + (reg - 'A');
-
-  throw std::runtime_error("invalid register name: " + s);
+  return tk.value;
 }
 
 uint16_t Assembler::resolve_immediate_and_label(const Token &tk) {
   if (tk.type == TokenType::Immediate)
     return parse_immediate(tk.text);
   if (tk.type == TokenType::LabelRef) {
-    if (label_table.count(tk.text))
-      return label_table[tk.text];
-    else {
-      std::ostringstream oss;
-      oss << "error: unknown label: " << tk.text;
-      throw std::runtime_error(oss.str());
-    }
+    const auto it = label_table.find(tk.text);
+    if (it != label_table.end())
+      return AddressOperand(tk.text, it->second);
+
+    // forward reference, patched once the label is defined
+    fixups.push_back({encode_offset, tk.text});
+    return 0;
   }
   return 0;
 }
 
 // ====== Instruction parsers ======
 
-uint16_t Assembler::parse_JP(const std::vector<Token> &line) {
+uint16_t Assembler::parse_JP(const TokenLine &line) {
   // ! nnn could also be a label
 
   // 1nnn - JP addr
   if (line.size() == 2 && is_immediate_or_label(line[1])) {
     uint16_t addr = resolve_immediate_and_label(line[1]);
-    return 0x1000 | (addr & 0x0FFF);
+    return EncodeInstruction(InstructionKind::JP, 0, 0, addr);
   }
 
   // Bnnn - JP V0, addr
   if (line.size() == 4 && line[1].type == TokenType::Register &&
-      line[1].text == "V0" && line[2].type == TokenType::Comma &&
+      line[1].value == 0 && line[2].type == TokenType::Comma &&
       is_immediate_or_label(line[3])) {
     uint16_t addr = resolve_immediate_and_label(line[3]);
-    return 0xB000 | (addr & 0x0FFF);
+    return EncodeInstruction(InstructionKind::JP_V0, 0, 0, addr);
   }
 
   throw_invalid_instruction("JP", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_CALL(const std::vector<Token> &line) {
+uint16_t Assembler::parse_CALL(const TokenLine &line) {
   // ! nnn could also be a label
 
   // 2nnn - CALL addr
   if (line.size() == 2 && is_immediate_or_label(line[1])) {
     uint16_t addr = resolve_immediate_and_label(line[1]);
-    return 0x2000 | (addr & 0x0FFF);
+    return EncodeInstruction(InstructionKind::CALL, 0, 0, addr);
   }
 
   throw_invalid_instruction("CALL", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_SE(std::vector<Token> &line) {
+uint16_t Assembler::parse_SE(const TokenLine &line) {
 
   // 3xkk - SE Vx, byte
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Immediate) {
 
-    uint8_t x = parse_register(line[1].text);
+    uint8_t x = parse_register(line[1]);
     uint16_t kk = parse_immediate(line[3].text);
     if (kk > 0xFF)
       throw std::runtime_error("immediate value out of range for a byte");
 
-    return (0x3000 | (x << 8u)) | kk;
+    return EncodeInstruction(InstructionKind::SE_BYTE, x, 0, kk);
   }
 
   // 5xy0 - SE Vx, Vy
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register) {
 
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
 
-    return (0x5000 | (x << 8u)) | (y << 4u);
+    return EncodeInstruction(InstructionKind::SE_REG, x, y);
   }
 
   throw_invalid_instruction("SE", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_SNE(std::vector<Token> &line) {
+uint16_t Assembler::parse_SNE(const TokenLine &line) {
 
   // 4xkk - SNE Vx, byte
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Immediate) {
 
-    uint8_t x = parse_register(line[1].text);
+    uint8_t x = parse_register(line[1]);
     uint16_t kk = parse_immediate(line[3].text);
     if (kk > 0xFF)
       throw std::runtime_error("immediate value out of range for a byte");
 
-    return (0x4000 | (x << 8u)) | kk;
+    return EncodeInstruction(InstructionKind::SNE_BYTE, x, 0, kk);
   }
 
   // 9xy0 - SNE Vx, Vy
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register) {
 
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
 
-    return (0x9000 | (x << 8u)) | (y << 4u);
+    return EncodeInstruction(InstructionKind::SNE_REG, x, y);
   }
 
   throw_invalid_instruction("SNE", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_ADD(std::vector<Token> &line) {
+uint16_t Assembler::parse_ADD(const TokenLine &line) {
 
   // 7xkk - ADD Vx, byte
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Immediate) {
 
-    uint8_t x = parse_register(line[1].text);
+    uint8_t x = parse_register(line[1]);
     uint16_t kk = parse_immediate(line[3].text);
     if (kk > 0xFF)
       throw std::runtime_error("immediate value out of range for a byte");
 
-    return (0x7000 | (x << 8u)) | kk;
+    return EncodeInstruction(InstructionKind::ADD_BYTE, x, 0, kk);
   }
 
   // 8xy4 - ADD Vx, Vy
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register) {
 
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
 
-    return (0x8004 | (x << 8u)) | (y << 4u);
+    return EncodeInstruction(InstructionKind::ADD_REG, x, y);
   }
 
   // Fx1E - ADD I, Vx
-  if (line[1].type == TokenType::SpecialRegister && line[1].text == "I" &&
+  if (is_special_register(line[1], SpecialRegister::I) &&
       line[2].type == TokenType::Comma && line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[3].text);
+    uint8_t x = parse_register(line[3]);
 
-    return (0xF01E | (x << 8u));
+    return EncodeInstruction(InstructionKind::ADD_I, x);
   }
 
   throw_invalid_instruction("ADD", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_AND(std::vector<Token> &line) {
+uint16_t Assembler::parse_AND(const TokenLine &line) {
   if (line.size() != 4)
     throw_invalid_instruction("AND", line);
 
   // 8xy2 - AND Vx, Vy
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
 
-    return (0x8002) | (x << 8u) | (y << 4u);
+    return EncodeInstruction(InstructionKind::AND, x, y);
   }
 
   throw_invalid_instruction("AND", line);
   return 0x0000;
 }
 
-uint16_t Assembler::parse_OR(std::vector<Token> &line) {
+uint16_t Assembler::parse_OR(const TokenLine &line) {
   if (line.size() != 4)
     throw_invalid_instruction("OR", line);
 
   // 8xy1 - OR Vx, Vy
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
 
-    return (0x8001) | (x << 8u) | (y << 4u);
+    return EncodeInstruction(InstructionKind::OR, x, y);
   }
 
   throw_invalid_instruction("OR", line);
   return 0x0000;
 }
 
-uint16_t Assembler::parse_XOR(std::vector<Token> &line) {
+uint16_t Assembler::parse_XOR(const TokenLine &line) {
   if (line.size() != 4)
     throw_invalid_instruction("XOR", line);
 
   // 8xy3 - XOR Vx, Vy
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
 
-    return (0x8003) | (x << 8u) | (y << 4u);
+    return EncodeInstruction(InstructionKind::XOR, x, y);
   }
 
   throw_invalid_instruction("XOR", line);
   return 0x0000;
 }
 
-uint16_t Assembler::parse_SUB(std::vector<Token> &line) {
+uint16_t Assembler::parse_SUB(const TokenLine &line) {
   if (line.size() != 4)
     throw_invalid_instruction("SUB", line);
 
   // 8xy5 - SUB Vx, Vy
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
 
-    return (0x8005) | (x << 8u) | (y << 4u);
+    return EncodeInstruction(InstructionKind::SUB, x, y);
   }
 
   throw_invalid_instruction("SUB", line);
   return 0x0000;
 }
 
-uint16_t Assembler::parse_SUBN(std::vector<Token> &line) {
+uint16_t Assembler::parse_SUBN(const TokenLine &line) {
   if (line.size() != 4)
     throw_invalid_instruction("SUBN", line);
 
   // 8xy7 - SUBN Vx, Vy
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
 
-    return (0x8007) | (x << 8u) | (y << 4u);
+    return EncodeInstruction(InstructionKind::SUBN, x, y);
   }
 
   throw_invalid_instruction("SUBN", line);
   return 0x0000;
 }
 
-uint16_t Assembler::parse_LD(std::vector<Token> &line) {
+uint16_t Assembler::parse_LD(const TokenLine &line) {
   if (line.size() != 4)
     throw_invalid_instruction("LD", line);
 
@@ -332,281 +415,234 @@ uint16_t Assembler::parse_LD(std::vector<Token> &line) {
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Immediate) {
 
-    uint8_t x = parse_register(line[1].text);
+    uint8_t x = parse_register(line[1]);
     uint16_t kk = parse_immediate(line[3].text);
     if (kk > 0xFF)
       throw std::runtime_error("immediate value out of range for a byte");
 
-    return (0x6000 | (x << 8u)) | kk;
+    return EncodeInstruction(InstructionKind::LD_BYTE, x, 0, kk);
   }
 
   // 8xy0 - LD Vx, Vy
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register) {
 
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
 
-    return (0x8000 | (x << 8u)) | (y << 4u);
+    return EncodeInstruction(InstructionKind::LD_REG, x, y);
   }
 
   // Annn - LD I, addr
-  if (line[1].type == TokenType::SpecialRegister && line[1].text == "I" &&
+  if (is_special_register(line[1], SpecialRegister::I) &&
       line[2].type == TokenType::Comma && is_immediate_or_label(line[3])) {
     uint16_t addr = resolve_immediate_and_label(line[3]);
 
     if (addr > 0xFFF)
       throw std::runtime_error("immediate value out of range ( <= 0xFFF)");
 
-    return (0xA000 | addr);
+    return EncodeInstruction(InstructionKind::LD_I, 0, 0, addr);
   }
 
   // Fx55 - LD [I], Vx
   if (line[1].type == TokenType::MemoryDereference &&
       line[2].type == TokenType::Comma && line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[3].text);
-    return (0xF055 | (x << 8u));
+    uint8_t x = parse_register(line[3]);
+    return EncodeInstruction(InstructionKind::STORE, x);
   }
 
   // Fx65 - LD Vx, [I]
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::MemoryDereference) {
-    uint8_t x = parse_register(line[1].text);
-    return (0xF065 | (x << 8u));
+    uint8_t x = parse_register(line[1]);
+    return EncodeInstruction(InstructionKind::LOAD, x);
   }
 
   // Fx07 - LD Vx, DT
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
-      line[3].type == TokenType::SpecialRegister && line[3].text == "DT") {
-    uint8_t x = parse_register(line[1].text);
-    return (0xF007 | (x << 8u));
+      is_special_register(line[3], SpecialRegister::DT)) {
+    uint8_t x = parse_register(line[1]);
+    return EncodeInstruction(InstructionKind::LD_FROM_DT, x);
   }
 
   // Fx15 - LD DT, Vx
-  if (line[1].type == TokenType::SpecialRegister && line[1].text == "DT" &&
+  if (is_special_register(line[1], SpecialRegister::DT) &&
       line[2].type == TokenType::Comma && line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[3].text);
-    return (0xF015 | (x << 8u));
+    uint8_t x = parse_register(line[3]);
+    return EncodeInstruction(InstructionKind::LD_DT, x);
   }
 
   // Fx18 - LD ST, Vx
-  if (line[1].type == TokenType::SpecialRegister && line[1].text == "ST" &&
+  if (is_special_register(line[1], SpecialRegister::ST) &&
       line[2].type == TokenType::Comma && line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[3].text);
-    return (0xF018 | (x << 8u));
+    uint8_t x = parse_register(line[3]);
+    return EncodeInstruction(InstructionKind::LD_ST, x);
   }
 
   // Fx29 - LD F, Vx
-  if (line[1].type == TokenType::SpecialMnemonic && line[1].text == "F" &&
+  if (is_special_mnemonic(line[1], SpecialMnemonic::F) &&
       line[2].type == TokenType::Comma && line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[3].text);
-    return (0xF029 | (x << 8u));
+    uint8_t x = parse_register(line[3]);
+    return EncodeInstruction(InstructionKind::LD_FONT, x);
   }
 
   // Fx33 - LD B, Vx
-  if (line[1].type == TokenType::SpecialMnemonic && line[1].text == "B" &&
+  if (is_special_mnemonic(line[1], SpecialMnemonic::B) &&
       line[2].type == TokenType::Comma && line[3].type == TokenType::Register) {
-    uint8_t x = parse_register(line[3].text);
-    return (0xF033 | (x << 8u));
+    uint8_t x = parse_register(line[3]);
+    return EncodeInstruction(InstructionKind::LD_BCD, x);
   }
 
   // Fx0A - LD Vx, K
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
-      line[3].type == TokenType::SpecialMnemonic && line[3].text == "K") {
-    uint8_t x = parse_register(line[1].text);
-    return (0xF00A | (x << 8u));
+      is_special_mnemonic(line[3], SpecialMnemonic::K)) {
+    uint8_t x = parse_register(line[1]);
+    return EncodeInstruction(InstructionKind::LD_KEY, x);
   }
 
   throw_invalid_instruction("LD", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_RND(std::vector<Token> &line) {
+uint16_t Assembler::parse_RND(const TokenLine &line) {
 
   // Cxkk - RND Vx, byte
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Immediate) {
-    uint8_t x = parse_register(line[1].text);
+    uint8_t x = parse_register(line[1]);
     uint16_t kk = parse_immediate(line[3].text);
     if (kk > 0xFF)
       throw std::runtime_error("immediate value out of range for a byte");
 
-    return (0xC000 | (x << 8u)) | kk;
+    return EncodeInstruction(InstructionKind::RND, x, 0, kk);
   }
   throw_invalid_instruction("RND", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_SKP(std::vector<Token> &line) {
+uint16_t Assembler::parse_SKP(const TokenLine &line) {
   // Ex9E - SKP Vx
   if (line[1].type == TokenType::Register) {
-    uint8_t x = parse_register(line[1].text);
-    return (0xE09E | (x << 8u));
+    uint8_t x = parse_register(line[1]);
+    return EncodeInstruction(InstructionKind::SKP, x);
   }
 
   throw_invalid_instruction("SKP", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_SKNP(std::vector<Token> &line) {
+uint16_t Assembler::parse_SKNP(const TokenLine &line) {
   // ExA1 - SKNP Vx
   if (line[1].type == TokenType::Register) {
-    uint8_t x = parse_register(line[1].text);
-    return (0xE0A1 | (x << 8u));
+    uint8_t x = parse_register(line[1]);
+    return EncodeInstruction(InstructionKind::SKNP, x);
   }
 
   throw_invalid_instruction("SKNP", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_DRW(std::vector<Token> &line) {
+uint16_t Assembler::parse_DRW(const TokenLine &line) {
   // Dxyn - DRW Vx, Vy, nibble
   if (line[1].type == TokenType::Register && line[2].type == TokenType::Comma &&
       line[3].type == TokenType::Register && line[4].type == TokenType::Comma &&
       line[5].type == TokenType::Immediate) {
-    uint8_t x = parse_register(line[1].text);
-    uint8_t y = parse_register(line[3].text);
+    uint8_t x = parse_register(line[1]);
+    uint8_t y = parse_register(line[3]);
     uint16_t n = parse_immediate(line[5].text);
 
     if (n > 0xF)
       throw std::runtime_error("immediate value out of range for a nibble");
 
-    return (0xD000 | (x << 8u) | (y << 4u) | (n));
+    return EncodeInstruction(InstructionKind::DRW, x, y, n);
   }
   throw_invalid_instruction("DRW", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_SHR(std::vector<Token> &line) {
+uint16_t Assembler::parse_SHR(const TokenLine &line) {
   // 8xy6 - SHR Vx
   if (line[1].type == TokenType::Register) {
-    uint8_t x = parse_register(line[1].text);
-    return (0x8006 | (x << 8u));
+    uint8_t x = parse_register(line[1]);
+    return EncodeInstruction(InstructionKind::SHR, x);
   }
   throw_invalid_instruction("SHR", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_SHL(std::vector<Token> &line) {
+uint16_t Assembler::parse_SHL(const TokenLine &line) {
   // 8xyE - SHL Vx {, Vy}
   if (line[1].type == TokenType::Register) {
-    uint8_t x = parse_register(line[1].text);
-    return (0x800E | (x << 8u));
+    uint8_t x = parse_register(line[1]);
+    return EncodeInstruction(InstructionKind::SHL, x);
   }
   throw_invalid_instruction("SHL", line);
   return 0x0;
 }
 
-uint16_t Assembler::parse_CLS(std::vector<Token> &line) { return 0x00E0; }
+uint16_t Assembler::parse_CLS(const TokenLine &line) {
+  return EncodeInstruction(InstructionKind::CLS);
+}
 
-uint16_t Assembler::parse_RET(std::vector<Token> &line) { return 0x00EE; }
+uint16_t Assembler::parse_RET(const TokenLine &line) {
+  return EncodeInstruction(InstructionKind::RET);
+}
 
-uint16_t Assembler::assemble_instruction(std::vector<Token> line) {
+uint16_t Assembler::assemble_instruction(const TokenLine &line) {
 
   if (line.empty())
     return 0x0000;
 
-  std::string mnemonic = line[0].text;
-  std::transform(mnemonic.begin(), mnemonic.end(), mnemonic.begin(), ::toupper);
-
-  // CLS
-  if (mnemonic == "CLS")
-    return parse_CLS(line);
-
-  // RET
-  if (mnemonic == "RET")
-    return parse_RET(line);
-
-  // JP
-  if (mnemonic == "JP") {
-    return parse_JP(line);
-  }
-
-  // CALL
-  if (mnemonic == "CALL") {
-    return parse_CALL(line);
-  }
-
-  // SE
-  if (mnemonic == "SE") {
-    return parse_SE(line);
-  }
-
-  // SNE
-  if (mnemonic == "SNE") {
-    return parse_SNE(line);
-  }
-
-  // ADD
-  if (mnemonic == "ADD") {
-    return parse_ADD(line);
-  }
-
-  // AND
-  if (mnemonic == "AND") {
-    return parse_AND(line);
-  }
-
-  // OR
-  if (mnemonic == "OR") {
-    return parse_OR(line);
-  }
-
-  // XOR
-  if (mnemonic == "XOR") {
-    return parse_XOR(line);
-  }
-
-  // SUB
-  if (mnemonic == "SUB") {
-    return parse_SUB(line);
-  }
-
-  // SUBN
-  if (mnemonic == "SUBN") {
-    return parse_SUBN(line);
-  }
-
-  // LD
-  if (mnemonic == "LD") {
-    return parse_LD(line);
-  }
-
-  // RND
-  if (mnemonic == "RND") {
-    return parse_RND(line);
-  }
-
-  // SKP
-  if (mnemonic == "SKP") {
-    return parse_SKP(line);
-  }
-
-  // SKPN
-  if (mnemonic == "SKNP") {
-    return parse_SKNP(line);
-  }
-
-  // DRW
-  if (mnemonic == "DRW") {
-    return parse_DRW(line);
-  }
-
-  // SHR
-  if (mnemonic == "SHR") {
-    return parse_SHR(line);
-  }
+  // indexed by Mnemonic
+  static constexpr InstructionParser parsers[MNEMONIC_COUNT] = {
+      &Assembler::parse_CLS,  // CLS
+      &Assembler::parse_RET,  // RET
+      &Assembler::parse_JP,   // JP
+      &Assembler::parse_CALL, // CALL
+      &Assembler::parse_SE,   // SE
+      &Assembler::parse_SNE,  // SNE
+      &Assembler::parse_LD,   // LD
+      &Assembler::parse_ADD,  // ADD
+      &Assembler::parse_OR,   // OR
+      &Assembler::parse_AND,  // AND
+      &Assembler::parse_XOR,  // XOR
+      &Assembler::parse_SUB,  // SUB
+      &Assembler::parse_SUBN, // SUBN
+      &Assembler::parse_SHR,  // SHR
+      &Assembler::parse_SHL,  // SHL
+      &Assembler::parse_RND,  // RND
+      &Assembler::parse_DRW,  // DRW
+      &Assembler::parse_SKP,  // SKP
+      &Assembler::parse_SKNP, // SKNP
+  };
+
+  // the tokenizer only classifies uppercase mnemonics, but the instruction
+  // position accepts any case
+  const Token &first = line[0];
+  const Mnemonic mnemonic = first.type == TokenType::Mnemonic
+                                ? static_cast<Mnemonic>(first.value)
+                                : MnemonicFromText(first.text, true);
+
+  if (mnemonic == Mnemonic::None) {
+    std::string upper(first.text);
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    throw_invalid_instruction(upper.c_str(), line);
+  }
+
+  return (this->*parsers[static_cast<size_t>(mnemonic)])(line);
+}
 
-  // SHL
-  if (mnemonic == "SHL") {
-    return parse_SHL(line);
-  }
+Assembler::Assembler(std::string_view source_code)
+    : Assembler(source_code, nullptr) {}
 
-  throw_invalid_instruction(mnemonic.c_str(), line);
-  return 0x0000;
+Module Assembler::AssembleModule(std::string_view source_code) {
+  Module module;
+  Assembler assembler(source_code, &module);
+  return module;
 }
 
-Assembler::Assembler(std::string source_code) : tkzr(source_code) {
+Assembler::Assembler(std::string_view source_code, Module *module)
+    : tkzr(source_code) {
 
   // ====== Tokenizer Tester ======
 
@@ -624,44 +660,74 @@ Assembler::Assembler(std::string source_code) : tkzr(source_code) {
   //   PC += 2;
   // }
 
-  run_first_pass(); //
-
+  // one pass: labels are defined as they are met, and references to labels
+  // further down are patched by resolve_fixups() at the end
   uint16_t PC = 0x200;
 
-  for (const auto &line : tkzr.get_token_lines()) {
+  const auto &token_lines = tkzr.get_token_lines();
+  for (size_t n = 0; n < token_lines.size(); n += 1) {
+    const TokenLine &line = token_lines[n];
     if (line.empty())
       continue;
 
-    size_t start = 0;
     if (line.front().type == TokenType::LabelDef) {
-      start = 1;
-      if (line.size() == 1)
-        continue;
+      if (module) {
+        const auto piece = static_cast<uint32_t>(module->includes.size());
+        module->symbols.push_back({std::string(label_name(line)),
+                                   static_cast<uint32_t>(bytes.size()), piece});
+      } else {
+        define_label(label_name(line), PC);
+      }
     }
 
-    if (line[start].type == TokenType::ByteDirective) {
-      for (size_t i = start + 1; i < line.size(); i += 1) {
-        if (line[i].type == TokenType::Immediate) {
-          uint16_t val = parse_immediate(line[i].text);
+    if (is_include(line)) {
+      if (!module)
+        throw std::runtime_error(INCLUDE_NEEDS_FILE);
 
-          if (val > 0xFF)
-            throw std::runtime_error("immediate value out of range for a byte");
-          bytes.push_back(val);
-          PC += 1;
-        }
-      }
-    } else {
-      uint16_t opcode = assemble_instruction(line);
+      const Token &path = line[body_start(line) + 1];
+      if (path.type != TokenType::String || line.size() != body_start(line) + 2)
+        throw std::runtime_error("expected .include \"<file>\"");
 
-      bytes.push_back(((opcode & 0xFF00u) >> 8u));
-      bytes.push_back((opcode & 0x00FFu));
+      module->includes.push_back(
+          {std::string(path.text), static_cast<uint32_t>(bytes.size())});
+      continue;
+    }
+
+    const size_t size = line_size(line);
+    if (size == 0)
+      continue; // only label
 
-      // std::cout << "0x" << std::hex << std::setw(4) << std::setfill('0')
-      //           << std::uppercase << opcode << std::endl;
+    const size_t offset = bytes.size();
+    bytes.resize(offset + size);
+    encode_line(line, offset);
 
-      PC += 2;
+    if (module) {
+      module->lines.push_back({static_cast<uint32_t>(offset),
+                               static_cast<uint32_t>(size),
+                               static_cast<uint32_t>(n + 1),
+                               static_cast<uint32_t>(module->includes.size())});
     }
+
+    PC += size;
+  }
+
+  if (!module) {
+    resolve_fixups();
+    return;
   }
+
+  // the label table stayed empty, so every reference is a relocation. an
+  // opcode on an include boundary comes after the include.
+  for (const auto &fixup : fixups) {
+    uint32_t piece = 0;
+    while (piece < module->includes.size() &&
+           module->includes[piece].offset <= fixup.offset)
+      piece += 1;
+
+    module->relocations.push_back({std::string(fixup.label),
+                                   static_cast<uint32_t>(fixup.offset), piece});
+  }
+  module->bytes = std::move(bytes);
 }
 
 std::vector<uint8_t> Assembler::GetBytes() const { return bytes; }
@@ -679,12 +745,17 @@ void Assembler::WriteToFile(std::string path) const {
 }
 
 Assembler Assembler::FromFile(const std::string &filename) {
-  std::ifstream file(filename);
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
   if (!file) {
     throw std::runtime_error("failed to open source file: " + filename);
   }
 
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  return Assembler(buffer.str());
+  // one read straight into a buffer of the right size
+  std::string buffer(static_cast<size_t>(file.tellg()), '\0');
+  file.seekg(0, std::ios::beg);
+  if (!file.read(buffer.data(), buffer.size())) {
+    throw std::runtime_error("failed to read source file: " + filename);
+  }
+
+  return Assembler(buffer);
 }
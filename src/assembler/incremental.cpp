@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../../include/assembler/incremental.hpp"
+
+IncrementalAssembler::IncrementalAssembler() : assembler("") {}
+
+// ====== Updates ======
+IncrementalAssembler::UpdateStats
+IncrementalAssembler::Update(std::string_view next_source) {
+  try {
+    UpdateStats stats = rebuild(next_source);
+    output = assembler.bytes;
+    valid = true;
+    return stats;
+  } catch (...) {
+    // lines and chunks may be half updated
+    valid = false;
+    throw;
+  }
+}
+
+IncrementalAssembler::UpdateStats
+IncrementalAssembler::rebuild(std::string_view next_source_view) {
+  UpdateStats stats;
+
+  // heap buffer, so the line views survive the swap into `source`
+  std::vector<char> next_source(next_source_view.begin(),
+                                next_source_view.end());
+  std::vector<std::string_view> next_lines =
+      split_lines({next_source.data(), next_source.size()});
+
+  const bool full = !valid || chunks.size() >= MAX_CHUNKS;
+  if (full) {
+    assembler.label_table.clear();
+    assembler.bytes.clear();
+    lines.clear();
+    line_text.clear();
+    chunks.clear();
+  }
+
+  // the edited region: everything between the unchanged first and last lines
+  const size_t old_count = line_text.size();
+  const size_t common = std::min(old_count, next_lines.size());
+  size_t prefix = 0;
+  while (prefix < common && line_text[prefix] == next_lines[prefix])
+    prefix += 1;
+
+  size_t suffix = 0;
+  while (suffix < common - prefix &&
+         line_text[old_count - 1 - suffix] ==
+             next_lines[next_lines.size() - 1 - suffix])
+    suffix += 1;
+
+  if (prefix == old_count && prefix == next_lines.size()) {
+    source.swap(next_source);
+    line_text.swap(next_lines);
+    return stats;
+  }
+
+  const size_t first = prefix;
+  const size_t old_last = old_count - suffix;
+  const size_t new_last = next_lines.size() - suffix;
+
+  // tokenize only the edited lines, '\n' of the last one included
+  std::vector<Line> region;
+  if (new_last > first) {
+    const char *begin = next_lines[first].data();
+    const char *end =
+        next_lines[new_last - 1].data() + next_lines[new_last - 1].size();
+    if (end < next_source.data() + next_source.size())
+      end += 1;
+
+    chunks.emplace_back(std::string_view(begin, end - begin));
+    for (const auto &tokens : chunks.back().get_token_lines())
+      region.push_back(make_line(tokens));
+    stats.lines_tokenized = region.size();
+  }
+
+  // splice the region into the lines and the output
+  auto &bytes = assembler.bytes;
+  const size_t region_offset =
+      first < lines.size() ? lines[first].offset : bytes.size();
+
+  size_t old_region_size = 0;
+  for (size_t i = first; i < old_last; i += 1)
+    old_region_size += lines[i].size;
+
+  size_t new_region_size = 0;
+  for (const auto &line : region)
+    new_region_size += line.size;
+
+  lines.erase(lines.begin() + first, lines.begin() + old_last);
+  lines.insert(lines.begin() + first, region.begin(), region.end());
+
+  bytes.erase(bytes.begin() + region_offset,
+              bytes.begin() + region_offset + old_region_size);
+  bytes.insert(bytes.begin() + region_offset, new_region_size, 0);
+
+  size_t offset = region_offset;
+  for (size_t i = first; i < lines.size(); i += 1) {
+    lines[i].offset = offset;
+    offset += lines[i].size;
+  }
+
+  // labels after the region move when its size changed. Keys of the old
+  // table point into chunks that are still alive.
+  auto old_labels = std::move(assembler.label_table);
+  assembler.label_table.clear();
+  for (const auto &line : lines) {
+    if (!line.tokens.empty() &&
+        line.tokens.front().type == TokenType::LabelDef)
+      assembler.define_label(Assembler::label_name(line.tokens),
+                             static_cast<uint16_t>(0x200 + line.offset));
+  }
+
+  std::unordered_set<std::string_view> moved;
+  if (!full) {
+    for (const auto &[name, addr] : assembler.label_table) {
+      const auto it = old_labels.find(name);
+      if (it == old_labels.end() || it->second != addr)
+        moved.insert(name);
+    }
+    for (const auto &entry : old_labels) {
+      if (assembler.label_table.find(entry.first) ==
+          assembler.label_table.end())
+        moved.insert(entry.first);
+    }
+  }
+
+  // re-encode the region and every instruction that points at a moved label
+  auto encode = [&](const Line &line) {
+    if (line.size == 0)
+      return;
+    assembler.encode_line(line.tokens, line.offset);
+    stats.lines_encoded += 1;
+  };
+
+  assembler.fixups.clear();
+  const size_t region_end = first + region.size();
+  for (size_t i = first; i < region_end; i += 1)
+    encode(lines[i]);
+
+  if (!moved.empty()) {
+    for (size_t i = 0; i < lines.size(); i += 1) {
+      if ((i >= first && i < region_end) || !lines[i].has_label_ref)
+        continue;
+
+      for (const auto &tk : lines[i].tokens) {
+        if (tk.type == TokenType::LabelRef &&
+            moved.find(tk.text) != moved.end()) {
+          encode(lines[i]);
+          break;
+        }
+      }
+    }
+  }
+
+  // every label is defined by now, so this only throws for unknown ones
+  assembler.resolve_fixups();
+
+  source.swap(next_source);
+  line_text.swap(next_lines);
+  stats.full = full;
+  return stats;
+}
+
+// ====== Helpers ======
+std::vector<std::string_view>
+IncrementalAssembler::split_lines(std::string_view s) {
+  // same lines as the tokenizer: one per '\n', plus an unterminated last one
+  std::vector<std::string_view> result;
+  size_t begin = 0;
+  while (begin < s.size()) {
+    size_t end = s.find('\n', begin);
+    if (end == std::string_view::npos)
+      end = s.size();
+    result.push_back(s.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return result;
+}
+
+IncrementalAssembler::Line
+IncrementalAssembler::make_line(const TokenLine &tokens) {
+  if (Assembler::is_include(tokens))
+    throw std::runtime_error(Assembler::INCLUDE_NEEDS_FILE);
+
+  Line line;
+  line.tokens = tokens;
+  line.size = Assembler::line_size(tokens);
+  for (const auto &tk : tokens) {
+    if (tk.type == TokenType::LabelRef)
+      line.has_label_ref = true;
+  }
+  return line;
+}
+
+// ====== Accessors ======
+const std::vector<uint8_t> &IncrementalAssembler::GetBytes() const {
+  return output;
+}
+
+const std::unordered_map<std::string_view, uint16_t> &
+IncrementalAssembler::GetLabelTable() const {
+  return assembler.label_table;
+}
+
+void IncrementalAssembler::WriteToFile(const std::string &path) const {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open file for writing: " + path);
+  }
+
+  file.write(reinterpret_cast<const char *>(output.data()), output.size());
+  if (!file) {
+    throw std::runtime_error("failed to write data to file: " + path);
+  }
+}
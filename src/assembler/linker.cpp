@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "../../include/assembler/assembler.hpp"
+#include "../../include/assembler/linker.hpp"
+#include "../../include/utils/thread_pool.hpp"
+
+namespace fs = std::filesystem;
+
+Linker::Linker(const std::vector<std::string> &inputs,
+               const LinkOptions &options)
+    : options(options) {
+  const auto roots = load(inputs);
+  link(roots);
+
+  stats.modules = units.size();
+  for (const auto &unit : units) {
+    if (unit.cached)
+      stats.cached += 1;
+  }
+}
+
+// ====== Loading ======
+static std::vector<uint8_t> read_file(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open source file: " + path);
+  }
+
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+std::vector<size_t> Linker::load(const std::vector<std::string> &inputs) {
+  std::unordered_map<std::string, size_t> index;
+
+  auto unit_for = [&](const fs::path &path) {
+    std::string key = fs::weakly_canonical(path).string();
+
+    const auto it = index.find(key);
+    if (it != index.end())
+      return it->second;
+
+    units.push_back({key, {}, {}, false});
+    index.emplace(std::move(key), units.size() - 1);
+    return units.size() - 1;
+  };
+
+  std::vector<size_t> roots;
+  for (const auto &input : inputs)
+    roots.push_back(unit_for(input));
+
+  // breadth first: a level is every file first seen by the previous one
+  std::unique_ptr<ThreadPool> pool;
+  size_t level_begin = 0;
+  while (level_begin < units.size()) {
+    const size_t level_end = units.size();
+
+    auto load_unit = [&](size_t i) {
+      Unit &unit = units[level_begin + i];
+      try {
+        unit.module = load_module(unit.path, unit.cached);
+      } catch (const std::exception &e) {
+        throw std::runtime_error(unit.path + ": " + e.what());
+      }
+    };
+
+    if (level_end - level_begin == 1) {
+      load_unit(0);
+    } else {
+      if (!pool)
+        pool = std::make_unique<ThreadPool>(options.threads);
+      pool->ParallelFor(level_end - level_begin, load_unit);
+    }
+
+    // may grow `units`, so index instead of holding references
+    for (size_t u = level_begin; u < level_end; u += 1) {
+      const fs::path dir = fs::path(units[u].path).parent_path();
+      for (size_t k = 0; k < units[u].module.includes.size(); k += 1) {
+        const size_t included =
+            unit_for(dir / units[u].module.includes[k].path);
+        units[u].includes.push_back(included);
+      }
+    }
+
+    level_begin = level_end;
+  }
+
+  return roots;
+}
+
+Module Linker::load_module(const std::string &path, bool &cached) const {
+  const std::vector<uint8_t> data = read_file(path);
+  const std::string_view source(reinterpret_cast<const char *>(data.data()),
+                                data.size());
+
+  cached = false;
+  if (!options.cache)
+    return Assembler::AssembleModule(source);
+
+  // a missing or unreadable entry is rebuilt
+  const uint64_t key = HashModuleSource(source);
+  if (auto entry = options.cache->Map(key, ".ch8mod")) {
+    try {
+      Module module = Module::Deserialize(std::vector<uint8_t>(
+          entry->data(), entry->data() + entry->size()));
+      cached = true;
+      return module;
+    } catch (const std::exception &) {
+    }
+  }
+
+  Module module = Assembler::AssembleModule(source);
+  const auto serialized = module.Serialize();
+  options.cache->Store(key, ".ch8mod", serialized.data(), serialized.size());
+
+  return module;
+}
+
+// ====== Linking ======
+void Linker::link(const std::vector<size_t> &roots) {
+  // image offset minus module offset, per unit and piece
+  std::vector<std::vector<int64_t>> piece_delta(units.size());
+  std::vector<bool> placed(units.size(), false);
+
+  std::function<void(size_t)> place = [&](size_t u) {
+    if (placed[u])
+      return;
+    placed[u] = true;
+
+    const Module &module = units[u].module;
+    auto &delta = piece_delta[u];
+
+    uint32_t from = 0;
+    for (size_t k = 0; k <= module.includes.size(); k += 1) {
+      const uint32_t to = k < module.includes.size()
+                              ? module.includes[k].offset
+                              : static_cast<uint32_t>(module.bytes.size());
+
+      delta.push_back(static_cast<int64_t>(bytes.size()) - from);
+      bytes.insert(bytes.end(), module.bytes.begin() + from,
+                   module.bytes.begin() + to);
+
+      if (k < module.includes.size())
+        place(units[u].includes[k]);
+      from = to;
+    }
+  };
+
+  for (size_t root : roots)
+    place(root);
+
+  // source order is address order, so the first definition wins as it does
+  // in a single file
+  std::vector<std::tuple<uint16_t, size_t, const std::string *>> symbols;
+  for (size_t u = 0; u < units.size(); u += 1) {
+    for (const auto &symbol : units[u].module.symbols) {
+      const int64_t offset = symbol.offset + piece_delta[u][symbol.piece];
+      symbols.emplace_back(static_cast<uint16_t>(0x200 + offset), u,
+                           &symbol.name);
+    }
+  }
+  std::sort(symbols.begin(), symbols.end());
+
+  for (size_t u = 0; u < units.size(); u += 1) {
+    for (const auto &line : units[u].module.lines) {
+      const int64_t offset = line.offset + piece_delta[u][line.piece];
+      source_lines.push_back({static_cast<uint16_t>(0x200 + offset),
+                              static_cast<uint16_t>(line.size),
+                              static_cast<uint32_t>(u), line.line});
+    }
+  }
+
+  for (const auto &[addr, u, name] : symbols) {
+    if (!label_table.emplace(*name, addr).second)
+      std::cerr << "error: duplicate label: " << *name << "\n";
+  }
+
+  for (size_t u = 0; u < units.size(); u += 1) {
+    for (const auto &relocation : units[u].module.relocations) {
+      const auto it = label_table.find(relocation.label);
+      if (it == label_table.end()) {
+        std::ostringstream oss;
+        oss << "error: unknown label: " << relocation.label;
+        throw std::runtime_error(oss.str());
+      }
+
+      const size_t pos =
+          relocation.offset + piece_delta[u][relocation.piece];
+      const uint16_t addr =
+          Assembler::AddressOperand(relocation.label, it->second);
+      bytes[pos] |= (addr >> 8u);
+      bytes[pos + 1] |= (addr & 0x00FFu);
+    }
+  }
+}
+
+// ====== Accessors ======
+const std::vector<uint8_t> &Linker::GetBytes() const { return bytes; }
+
+const std::unordered_map<std::string, uint16_t> &
+Linker::GetLabelTable() const {
+  return label_table;
+}
+
+const Linker::Stats &Linker::GetStats() const { return stats; }
+
+std::vector<std::string> Linker::GetSourceFiles() const {
+  std::vector<std::string> files;
+  for (const auto &unit : units)
+    files.push_back(unit.path);
+  return files;
+}
+
+const std::vector<DebugLine> &Linker::GetSourceLines() const {
+  return source_lines;
+}
+
+void Linker::WriteToFile(const std::string &path) const {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open file for writing: " + path);
+  }
+
+  file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+  if (!file) {
+    throw std::runtime_error("failed to write data to file: " + path);
+  }
+}
@@ -0,0 +1,192 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../../include/assembler/module.hpp"
+
+// bump whenever the encoder or the layout below changes
+static constexpr uint32_t MODULE_FORMAT_VERSION = 2;
+static constexpr char MODULE_MAGIC[4] = {'C', '8', 'M', 'D'};
+
+uint64_t HashModuleSource(std::string_view source) {
+  uint64_t hash = 0xcbf29ce484222325ull ^ MODULE_FORMAT_VERSION;
+  for (char c : source) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// ====== Serialization ======
+// little endian u32 lengths and offsets, strings as length + bytes
+namespace {
+
+void put_u32(std::vector<uint8_t> &out, uint32_t value) {
+  for (int i = 0; i < 4; i += 1)
+    out.push_back((value >> (8 * i)) & 0xFFu);
+}
+
+void put_string(std::vector<uint8_t> &out, const std::string &s) {
+  put_u32(out, s.size());
+  out.insert(out.end(), s.begin(), s.end());
+}
+
+class Reader {
+public:
+  Reader(const std::vector<uint8_t> &data, size_t pos) : data(data), pos(pos) {}
+
+  uint32_t u32() {
+    need(4);
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i += 1)
+      value |= static_cast<uint32_t>(data[pos + i]) << (8 * i);
+    pos += 4;
+    return value;
+  }
+
+  std::string string() {
+    const uint32_t size = u32();
+    need(size);
+    std::string s(reinterpret_cast<const char *>(data.data() + pos), size);
+    pos += size;
+    return s;
+  }
+
+  void bytes(std::vector<uint8_t> &out) {
+    const uint32_t size = u32();
+    need(size);
+    out.assign(data.begin() + pos, data.begin() + pos + size);
+    pos += size;
+  }
+
+  // element count of a list whose entries take at least `min_size` bytes
+  uint32_t count(size_t min_size) {
+    const uint32_t n = u32();
+    need(static_cast<size_t>(n) * min_size);
+    return n;
+  }
+
+  bool done() const { return pos == data.size(); }
+
+private:
+  const std::vector<uint8_t> &data;
+  size_t pos;
+
+  void need(size_t n) const {
+    if (data.size() - pos < n)
+      throw std::runtime_error("truncated module");
+  }
+};
+
+} // namespace
+
+std::vector<uint8_t> Module::Serialize() const {
+  std::vector<uint8_t> out(MODULE_MAGIC, MODULE_MAGIC + sizeof(MODULE_MAGIC));
+  put_u32(out, MODULE_FORMAT_VERSION);
+
+  put_u32(out, bytes.size());
+  out.insert(out.end(), bytes.begin(), bytes.end());
+
+  put_u32(out, symbols.size());
+  for (const auto &symbol : symbols) {
+    put_string(out, symbol.name);
+    put_u32(out, symbol.offset);
+    put_u32(out, symbol.piece);
+  }
+
+  put_u32(out, relocations.size());
+  for (const auto &relocation : relocations) {
+    put_string(out, relocation.label);
+    put_u32(out, relocation.offset);
+    put_u32(out, relocation.piece);
+  }
+
+  put_u32(out, includes.size());
+  for (const auto &include : includes) {
+    put_string(out, include.path);
+    put_u32(out, include.offset);
+  }
+
+  put_u32(out, lines.size());
+  for (const auto &line : lines) {
+    put_u32(out, line.offset);
+    put_u32(out, line.size);
+    put_u32(out, line.line);
+    put_u32(out, line.piece);
+  }
+
+  return out;
+}
+
+Module Module::Deserialize(const std::vector<uint8_t> &data) {
+  if (data.size() < sizeof(MODULE_MAGIC) ||
+      std::memcmp(data.data(), MODULE_MAGIC, sizeof(MODULE_MAGIC)) != 0)
+    throw std::runtime_error("not a module");
+
+  Reader in(data, sizeof(MODULE_MAGIC));
+  if (in.u32() != MODULE_FORMAT_VERSION)
+    throw std::runtime_error("module format version mismatch");
+
+  Module module;
+  in.bytes(module.bytes);
+
+  module.symbols.resize(in.count(12));
+  for (auto &symbol : module.symbols) {
+    symbol.name = in.string();
+    symbol.offset = in.u32();
+    symbol.piece = in.u32();
+  }
+
+  module.relocations.resize(in.count(12));
+  for (auto &relocation : module.relocations) {
+    relocation.label = in.string();
+    relocation.offset = in.u32();
+    relocation.piece = in.u32();
+  }
+
+  module.includes.resize(in.count(8));
+  for (auto &include : module.includes) {
+    include.path = in.string();
+    include.offset = in.u32();
+  }
+
+  module.lines.resize(in.count(16));
+  for (auto &line : module.lines) {
+    line.offset = in.u32();
+    line.size = in.u32();
+    line.line = in.u32();
+    line.piece = in.u32();
+  }
+
+  if (!in.done())
+    throw std::runtime_error("trailing data in module");
+
+  // offsets must stay inside the module. offset + 2 would wrap in 32 bits
+  for (const auto &relocation : module.relocations) {
+    if (module.bytes.size() < 2 ||
+        relocation.offset > module.bytes.size() - 2 ||
+        relocation.piece > module.includes.size())
+      throw std::runtime_error("corrupt module relocation");
+  }
+  for (const auto &symbol : module.symbols) {
+    if (symbol.offset > module.bytes.size() ||
+        symbol.piece > module.includes.size())
+      throw std::runtime_error("corrupt module symbol");
+  }
+  for (const auto &include : module.includes) {
+    if (include.offset > module.bytes.size())
+      throw std::runtime_error("corrupt module include");
+  }
+  for (const auto &line : module.lines) {
+    if (line.offset > module.bytes.size() ||
+        line.size > module.bytes.size() - line.offset ||
+        line.piece > module.includes.size())
+      throw std::runtime_error("corrupt module line");
+  }
+
+  return module;
+}
@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../../include/assembler/assembler.hpp"
+#include "../../include/assembler/optimizer.hpp"
+#include "../../include/instruction.hpp"
+
+// ====== Opcode shapes ======
+static uint8_t nibble_x(uint16_t opcode) { return (opcode >> 8u) & 0x0Fu; }
+static uint8_t nibble_y(uint16_t opcode) { return (opcode >> 4u) & 0x0Fu; }
+
+static InstructionKind kind_of(uint16_t opcode) {
+  return INSTRUCTION_KINDS[opcode];
+}
+
+static bool is_jump(uint16_t opcode) {
+  return kind_of(opcode) == InstructionKind::JP;
+}
+static bool is_call(uint16_t opcode) {
+  return kind_of(opcode) == InstructionKind::CALL;
+}
+static bool is_jump_v0(uint16_t opcode) {
+  return kind_of(opcode) == InstructionKind::JP_V0;
+}
+static bool is_load_byte(uint16_t opcode) {
+  return kind_of(opcode) == InstructionKind::LD_BYTE;
+}
+static bool is_load_register(uint16_t opcode) {
+  return kind_of(opcode) == InstructionKind::LD_REG;
+}
+
+// opcodes whose low 12 bits are an address
+static bool has_address(uint16_t opcode) { return HasAddress(kind_of(opcode)); }
+
+static bool is_skip(uint16_t opcode) { return IsSkip(kind_of(opcode)); }
+
+// bytes read from I on, 0 for opcodes that do not read through I
+static size_t read_length(uint16_t opcode) {
+  switch (kind_of(opcode)) {
+  case InstructionKind::DRW:
+    // Dxy0 is a 16x16 sprite on SUPER-CHIP
+    return (opcode & 0x000Fu) == 0 ? 32 : (opcode & 0x000Fu);
+  case InstructionKind::LOAD:
+    return nibble_x(opcode) + 1u;
+  default:
+    return 0;
+  }
+}
+
+// moves I within the data or writes through it
+static bool is_indexed_access(uint16_t opcode) {
+  const InstructionKind kind = kind_of(opcode);
+  return kind == InstructionKind::ADD_I || kind == InstructionKind::STORE ||
+         kind == InstructionKind::LD_BCD;
+}
+
+Optimizer::Optimizer(std::string_view source_code) {
+  // relocatable, so every label reference is kept as a relocation
+  Module module;
+  Assembler assembler(source_code, &module);
+  if (!module.includes.empty())
+    throw std::runtime_error(".include is not supported with -O");
+
+  std::unordered_map<uint32_t, const std::string *> targets;
+  for (const auto &relocation : module.relocations)
+    targets.emplace(relocation.offset, &relocation.label);
+
+  // ====== Items ======
+  std::unordered_set<std::string_view> defined;
+  std::vector<std::string> pending;
+  size_t offset = 0;
+
+  const auto &token_lines = assembler.tkzr.get_token_lines();
+  for (size_t n = 0; n < token_lines.size(); n += 1) {
+    const TokenLine &line = token_lines[n];
+    if (line.empty())
+      continue;
+
+    if (line.front().type == TokenType::LabelDef) {
+      const std::string_view name = Assembler::label_name(line);
+      if (defined.insert(name).second)
+        pending.emplace_back(name);
+      else
+        std::cerr << "error: duplicate label: " << name << "\n";
+    }
+
+    const size_t size = Assembler::line_size(line);
+    if (size == 0)
+      continue; // only label
+
+    Item item;
+    item.labels = std::move(pending);
+    item.line = static_cast<uint32_t>(n + 1);
+    pending.clear();
+
+    if (line[Assembler::body_start(line)].type == TokenType::ByteDirective) {
+      item.is_data = true;
+      item.data.assign(module.bytes.begin() + offset,
+                       module.bytes.begin() + offset + size);
+    } else {
+      item.opcode = (module.bytes[offset] << 8u) | module.bytes[offset + 1];
+      const auto it = targets.find(static_cast<uint32_t>(offset));
+      if (it != targets.end())
+        item.target = *it->second;
+    }
+
+    items.push_back(std::move(item));
+    offset += size;
+  }
+  trailing_labels = std::move(pending);
+
+  for (const auto &item : items) {
+    if (item.is_data)
+      continue;
+
+    if (is_jump_v0(item.opcode))
+      has_jump_table = true;
+    if (is_indexed_access(item.opcode))
+      indexes_data = true;
+    longest_read = std::max(longest_read, read_length(item.opcode));
+
+    const uint16_t addr = item.opcode & 0x0FFFu;
+    if (has_address(item.opcode) && item.target.empty() && addr >= 0x200 &&
+        addr < 0x200 + offset)
+      fixed_layout = true;
+  }
+
+  // one edit per call, so every pass sees a consistent layout
+  while (thread_jumps() | remove_unreachable() | fold_loads() |
+         merge_data_blocks()) {
+  }
+
+  emit();
+  stats.bytes_saved = offset - bytes.size();
+}
+
+// ====== Passes ======
+bool Optimizer::thread_jumps() {
+  const auto at = label_items();
+  bool changed = false;
+
+  for (auto &item : items) {
+    if (item.is_data || item.target.empty() ||
+        !(is_jump(item.opcode) || is_call(item.opcode)))
+      continue;
+
+    // a cycle of jumps is left where it is
+    std::unordered_set<std::string_view> seen;
+    std::string_view next = item.target;
+    while (seen.insert(next).second) {
+      const auto it = at.find(std::string(next));
+      if (it == at.end() || it->second >= items.size())
+        break;
+
+      const Item &dest = items[it->second];
+      if (dest.is_data || !is_jump(dest.opcode) || dest.target.empty())
+        break;
+      next = dest.target;
+    }
+
+    if (next != item.target) {
+      item.target = std::string(next);
+      stats.jumps_threaded += 1;
+      changed = true;
+    }
+  }
+
+  return changed;
+}
+
+bool Optimizer::remove_unreachable() {
+  if (fixed_layout || has_jump_table)
+    return false;
+
+  for (size_t i = 0; i + 1 < items.size(); i += 1) {
+    const Item &item = items[i];
+    if (item.is_data || !is_jump(item.opcode) || follows_skip(i))
+      continue;
+
+    const Item &next = items[i + 1];
+
+    // JP to the next instruction
+    if (!item.target.empty()) {
+      for (const auto &label : next.labels) {
+        if (label == item.target) {
+          remove_item(i);
+          return true;
+        }
+      }
+    }
+
+    // nothing falls into, or is labelled at, the next instruction
+    if (!next.is_data && next.labels.empty()) {
+      remove_item(i + 1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool Optimizer::fold_loads() {
+  if (fixed_layout)
+    return false;
+
+  for (size_t i = 0; i < items.size(); i += 1) {
+    const Item &a = items[i];
+    if (a.is_data || follows_skip(i))
+      continue;
+
+    const bool a_loads =
+        is_load_byte(a.opcode) || is_load_register(a.opcode);
+    if (!a_loads)
+      continue;
+    const uint8_t x = nibble_x(a.opcode);
+
+    // LD Vx, Vx
+    if (is_load_register(a.opcode) && nibble_y(a.opcode) == x) {
+      remove_item(i);
+      return true;
+    }
+
+    if (i + 1 == items.size() || items[i + 1].is_data)
+      continue;
+    const Item &b = items[i + 1];
+
+    // the next instruction overwrites Vx without reading it
+    if (nibble_x(b.opcode) == x &&
+        (is_load_byte(b.opcode) ||
+         (is_load_register(b.opcode) && nibble_y(b.opcode) != x))) {
+      remove_item(i);
+      return true;
+    }
+
+    // LD Vx, Vy then LD Vy, Vx: the second copies Vy onto itself
+    if (is_load_register(a.opcode) && is_load_register(b.opcode) &&
+        nibble_x(b.opcode) == nibble_y(a.opcode) && nibble_y(b.opcode) == x &&
+        b.labels.empty()) {
+      remove_item(i + 1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool Optimizer::merge_data_blocks() {
+  if (fixed_layout || indexes_data)
+    return false;
+
+  // a block is a labelled `.byte` line and the unlabelled ones after it
+  std::unordered_map<std::string, size_t> first_block;
+
+  for (size_t start = 0; start < items.size(); start += 1) {
+    if (!items[start].is_data || items[start].labels.empty())
+      continue;
+
+    size_t end = start;
+    std::string content;
+    do {
+      content.append(items[end].data.begin(), items[end].data.end());
+      end += 1;
+    } while (end < items.size() && items[end].is_data &&
+             items[end].labels.empty());
+
+    const auto [it, inserted] = first_block.emplace(content, start);
+    if (inserted || content.empty() || follows_skip(start))
+      continue;
+    // a sprite drawn from the data before may run on into this block, and
+    // one drawn from this block may run on into the data after it, which
+    // the kept copy is not followed by
+    if ((start > 0 && items[start - 1].is_data) ||
+        (end < items.size() && items[end].is_data) ||
+        content.size() < longest_read)
+      continue;
+
+    auto &labels = items[it->second].labels;
+    for (auto &label : items[start].labels)
+      labels.push_back(std::move(label));
+    items[start].labels.clear();
+
+    for (size_t i = end; i > start; i -= 1)
+      remove_item(i - 1);
+    stats.blocks_merged += 1;
+    return true;
+  }
+
+  return false;
+}
+
+// ====== Helpers ======
+std::unordered_map<std::string, size_t> Optimizer::label_items() const {
+  std::unordered_map<std::string, size_t> at;
+  for (size_t i = 0; i < items.size(); i += 1) {
+    for (const auto &label : items[i].labels)
+      at.emplace(label, i);
+  }
+  for (const auto &label : trailing_labels)
+    at.emplace(label, items.size());
+  return at;
+}
+
+bool Optimizer::follows_skip(size_t i) const {
+  return i > 0 && !items[i - 1].is_data && is_skip(items[i - 1].opcode);
+}
+
+void Optimizer::remove_item(size_t i) {
+  auto &moved_to =
+      i + 1 < items.size() ? items[i + 1].labels : trailing_labels;
+  moved_to.insert(moved_to.begin(),
+                  std::make_move_iterator(items[i].labels.begin()),
+                  std::make_move_iterator(items[i].labels.end()));
+
+  if (!items[i].is_data)
+    stats.instructions_removed += 1;
+  items.erase(items.begin() + i);
+}
+
+void Optimizer::emit() {
+  uint16_t PC = 0x200;
+  for (const auto &item : items) {
+    for (const auto &label : item.labels)
+      label_table.emplace(label, PC);
+    PC += item.size();
+  }
+  for (const auto &label : trailing_labels)
+    label_table.emplace(label, PC);
+
+  for (const auto &item : items) {
+    source_lines.push_back({static_cast<uint16_t>(0x200 + bytes.size()),
+                            static_cast<uint16_t>(item.size()), 0, item.line});
+
+    if (item.is_data) {
+      bytes.insert(bytes.end(), item.data.begin(), item.data.end());
+      continue;
+    }
+
+    uint16_t opcode = item.opcode;
+    if (!item.target.empty()) {
+      const auto it = label_table.find(item.target);
+      if (it == label_table.end()) {
+        std::ostringstream oss;
+        oss << "error: unknown label: " << item.target;
+        throw std::runtime_error(oss.str());
+      }
+      opcode |= Assembler::AddressOperand(item.target, it->second);
+    }
+
+    bytes.push_back(opcode >> 8u);
+    bytes.push_back(opcode & 0x00FFu);
+  }
+}
+
+// ====== Accessors ======
+const std::vector<uint8_t> &Optimizer::GetBytes() const { return bytes; }
+
+const std::unordered_map<std::string, uint16_t> &
+Optimizer::GetLabelTable() const {
+  return label_table;
+}
+
+const Optimizer::Stats &Optimizer::GetStats() const { return stats; }
+
+const std::vector<DebugLine> &Optimizer::GetSourceLines() const {
+  return source_lines;
+}
+
+void Optimizer::WriteToFile(const std::string &path) const {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open file for writing: " + path);
+  }
+
+  file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+  if (!file) {
+    throw std::runtime_error("failed to write data to file: " + path);
+  }
+}
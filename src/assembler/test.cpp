@@ -1,11 +1,19 @@
+#include <algorithm>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include "../../include/assembler/assembler.hpp"
+#include "../../include/assembler/constexpr_assembler.hpp"
+#include "../../include/assembler/module.hpp"
+#include "../../include/assembler/optimizer.hpp"
+#include "../../include/utils/artifact_cache.hpp"
 
-int TestAssembler() {
-
-  std::string source = R"(; Test program for tokenizer coverage
+constexpr std::string_view TEST_SOURCE = R"(; Test program for tokenizer coverage
 
 Start:
     CLS
@@ -51,7 +59,168 @@ Start:
 name:
     RET
 )";
-  Assembler chip8_asm(source);
+
+// assembled while compiling, a syntax error above fails the build
+constexpr auto TEST_ROM = CHIP8_ASSEMBLE(TEST_SOURCE);
+
+// CLS, RET, JP Start, JP V0, Start
+static_assert(TEST_ROM[0] == 0x00 && TEST_ROM[1] == 0xE0 &&
+                  TEST_ROM[2] == 0x00 && TEST_ROM[3] == 0xEE &&
+                  TEST_ROM[4] == 0x12 && TEST_ROM[5] == 0x00 &&
+                  TEST_ROM[6] == 0xB2 && TEST_ROM[7] == 0x00,
+              "constexpr assembler output changed");
+
+int TestAssembler() {
+  Assembler chip8_asm(TEST_SOURCE);
+
+  return EXIT_SUCCESS;
+}
+
+int TestConstexprAssembler() {
+  const auto bytes = Assembler(TEST_SOURCE).GetBytes();
+
+  if (!std::equal(TEST_ROM.begin(), TEST_ROM.end(), bytes.begin(),
+                  bytes.end()))
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
+
+// sprites + 5 is sprite_b, so the identical blocks must stay apart
+constexpr std::string_view INDEXED_SPRITES_SOURCE = R"(
+    LD V0, 5
+    LD I, sprites
+    ADD I, V0
+    DRW V1, V2, 5
+end:
+    JP end
+sprites:
+    .byte 0xF0, 0x90, 0x90, 0x90, 0xF0
+sprite_b:
+    .byte 0xF0, 0x90, 0x90, 0x90, 0xF0
+tail:
+    .byte 0xAA
+)";
+
+// nothing indexes past a label, the second copy goes
+constexpr std::string_view DUPLICATE_SPRITES_SOURCE = R"(
+    LD I, a
+    DRW V1, V2, 5
+    LD I, b
+    DRW V1, V2, 5
+end:
+    JP end
+a:
+    .byte 0xF0, 0x90, 0x90, 0x90, 0xF0
+    JP end
+b:
+    .byte 0xF0, 0x90, 0x90, 0x90, 0xF0
+)";
+
+// DRW through b reads on into c, which the copy at a is not followed by
+constexpr std::string_view SPRITE_RUNS_ON_SOURCE = R"(
+    LD I, b
+    DRW V0, V1, 2
+loop:
+    JP loop
+a:
+    .byte 0xF0
+    LD V2, 1
+b:
+    .byte 0xF0
+c:
+    .byte 0x90
+)";
+
+int TestOptimizerKeepsIndexedData() {
+  const Optimizer optimizer(INDEXED_SPRITES_SOURCE);
+  if (optimizer.GetStats().blocks_merged != 0 ||
+      optimizer.GetBytes() != Assembler(INDEXED_SPRITES_SOURCE).GetBytes())
+    return EXIT_FAILURE;
 
   return EXIT_SUCCESS;
 }
+
+int TestOptimizerKeepsSpriteTails() {
+  const Optimizer optimizer(SPRITE_RUNS_ON_SOURCE);
+  if (optimizer.GetStats().blocks_merged != 0 ||
+      optimizer.GetBytes() != Assembler(SPRITE_RUNS_ON_SOURCE).GetBytes())
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
+
+int TestOptimizerMergesData() {
+  const Optimizer optimizer(DUPLICATE_SPRITES_SOURCE);
+  const auto &labels = optimizer.GetLabelTable();
+  if (optimizer.GetStats().blocks_merged != 1 ||
+      labels.at("a") != labels.at("b"))
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
+
+// a corrupt cache entry must not make the linker patch past the bytes
+int TestModuleRejectsWrappedRelocation() {
+  for (uint32_t offset : {0xFFFFFFFEu, 0xFFFFFFFFu}) {
+    Module module;
+    module.bytes = {0x12, 0x00};
+    module.relocations.push_back({"start", offset, 0});
+    try {
+      Module::Deserialize(module.Serialize());
+      return EXIT_FAILURE;
+    } catch (const std::runtime_error &) {
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// --cache-dir may name a directory holding files of the user's own
+int TestArtifactCacheKeepsForeignFiles() {
+  namespace fs = std::filesystem;
+  const fs::path dir = fs::temp_directory_path() / "ch8asm_test_cache";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+
+  const fs::path foreign = dir / "important_user_data.bin";
+  std::ofstream(foreign) << std::string(4096, 'x');
+
+  const std::string entry(64, 'e');
+  ArtifactCache cache(dir.string(), 16);
+  cache.Store(1, ".ch8", entry.data(), entry.size());
+  cache.Store(2, ".ch8", entry.data(), entry.size());
+
+  const bool kept = fs::exists(foreign);
+  const bool evicted = !cache.Map(1, ".ch8");
+  fs::remove_all(dir);
+
+  return kept && evicted ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main() {
+  struct Test {
+    const char *name;
+    int (*run)();
+  };
+  const Test tests[] = {
+      {"assembler", TestAssembler},
+      {"constexpr assembler", TestConstexprAssembler},
+      {"optimizer keeps indexed data", TestOptimizerKeepsIndexedData},
+      {"optimizer keeps sprite tails", TestOptimizerKeepsSpriteTails},
+      {"optimizer merges data", TestOptimizerMergesData},
+      {"module rejects wrapped relocation",
+       TestModuleRejectsWrappedRelocation},
+      {"artifact cache keeps foreign files",
+       TestArtifactCacheKeepsForeignFiles},
+  };
+
+  int status = EXIT_SUCCESS;
+  for (const auto &test : tests) {
+    if (test.run() != EXIT_SUCCESS) {
+      std::cerr << "FAILED: " << test.name << "\n";
+      status = EXIT_FAILURE;
+    }
+  }
+  return status;
+}
@@ -5,7 +5,6 @@
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 // ====== Token ======
@@ -38,6 +37,12 @@ std::string Token::as_string() const {
   case TokenType::ByteDirective:
     type_as_string = "ByteDirective";
     break;
+  case TokenType::IncludeDirective:
+    type_as_string = "IncludeDirective";
+    break;
+  case TokenType::String:
+    type_as_string = "String";
+    break;
   case TokenType::Comma:
     type_as_string = "Comma";
     break;
@@ -57,141 +62,75 @@ std::string Token::as_string() const {
   return oss.str();
 }
 
-Token create_token(TokenType tt, std::string text) { return {tt, text}; }
+Token create_token(TokenType tt, std::string_view text, uint8_t value) {
+  return {tt, text, value};
+}
 
 // =======================
 // ====== Tokenizer ======
 // =======================
 
-// ====== Checkers ======
-bool Tokenizer::is_mnemonic(const std::string &s) {
-  return CHIP8_MNEMONICS.count(s);
-}
-
-bool Tokenizer::is_comma(const std::string &s) {
-  return s == ","; //
-}
-bool Tokenizer::is_immediate(const std::string &s) {
-  if (s.rfind("0x", 0) == 0)
-    return true;
-  return std::all_of(s.begin(), s.end(), ::isdigit);
-}
-bool Tokenizer::is_register(const std::string &s) {
-  return s.length() == 2 && s[0] == 'V' && std::isxdigit(s[1]); //
-}
-bool Tokenizer::is_labeldef(const std::string &s, size_t tokens_so_far) {
-  return tokens_so_far == 0 && !s.empty() && s.back() == ':'; //
-}
-bool Tokenizer::is_special_register(const std::string &s) {
-  return SPECIAL_REGISTERS.count(s);
-}
-bool Tokenizer::is_memory_dereference(const std::string &s) {
-  return s == "[I]"; //
-}
-bool Tokenizer::is_special_mnemonic(const std::string &s) {
-  return SPECIAL_MNEMONICS.count(s); //
-}
-bool Tokenizer::is_byte_directive(const std::string &s) {
-  return s == ".byte"; //
-}
-
-// strips away comment
-std::string Tokenizer::strip_comments(const std::string &line) {
-  auto comment_pos = line.find(';');
-
-  if (comment_pos != std::string::npos)
-    return line.substr(0, comment_pos);
-  return line;
+static bool is_separator(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
 }
 
-// adds gap between ','
-std::string Tokenizer::normalize(const std::string &line) {
-  std::string out;
-
-  for (char c : line) {
-    if (c == ',') {
-      out += ' ';
-      out += c;
-      out += ' ';
-    } else {
-      out += c;
+void Tokenizer::generate_token_lines() {
+  const char *p = source_code.data();
+  const char *const end = p + source_code.size();
+
+  // tokens of the line being scanned, copied into the arena at '\n'
+  std::vector<Token> scratch;
+
+  auto finish_line = [&]() {
+    TokenLine line;
+    line.count = scratch.size();
+    if (!scratch.empty()) {
+      Token *tokens = arena.AllocateArray<Token>(scratch.size());
+      std::copy(scratch.begin(), scratch.end(), tokens);
+      line.tokens = tokens;
     }
-  }
-  return out;
-}
-
-// splits up the line to individual string tokens
-std::vector<std::string>
-Tokenizer::generate_string_tokens(const std::string &line) {
-  std::istringstream iss(line);
-  std::vector<std::string> tokens;
-  std::string word;
-
-  while (iss >> word) {
-    tokens.push_back(word);
-  }
-  return tokens;
-}
-
-std::vector<Token>
-Tokenizer::tokenize(const std::vector<std::string> &string_tokens) {
-  std::vector<Token> tokens;
-
-  for (size_t i = 0; i < string_tokens.size(); i += 1) {
-    std::string st = string_tokens.at(i);
-    if (is_labeldef(st, tokens.size())) {
-      tokens.push_back(create_token(TokenType::LabelDef, st));
-    } else if (is_mnemonic(st)) {
-      tokens.push_back(create_token(TokenType::Mnemonic, st));
-    } else if (is_comma(st)) {
-      tokens.push_back(create_token(TokenType::Comma, st));
-    } else if (is_register(st)) {
-      tokens.push_back(create_token(TokenType::Register, st));
-    } else if (is_special_mnemonic(st)) {
-      tokens.push_back(create_token(TokenType::SpecialMnemonic, st));
-    } else if (is_special_register(st)) {
-      tokens.push_back(create_token(TokenType::SpecialRegister, st));
-    } else if (is_memory_dereference(st)) {
-      tokens.push_back(create_token(TokenType::MemoryDereference, st));
-    } else if (is_byte_directive(st)) {
-      tokens.push_back(create_token(TokenType::ByteDirective, st));
-    } else if (is_immediate(st)) {
-      tokens.push_back(create_token(TokenType::Immediate, st));
+    token_lines.push_back(line);
+    scratch.clear();
+  };
+
+  while (p < end) {
+    const char c = *p;
+
+    if (c == '\n') {
+      finish_line();
+      p += 1;
+    } else if (is_separator(c)) {
+      p += 1;
+    } else if (c == ';') {
+      // comment runs to the end of the line
+      while (p < end && *p != '\n')
+        p += 1;
+    } else if (c == ',') {
+      scratch.push_back(create_token(TokenType::Comma, std::string_view(p, 1)));
+      p += 1;
     } else {
-      tokens.push_back(create_token(TokenType::LabelRef, st));
-    }
-  }
+      const char *word = p;
+      while (p < end && !is_separator(*p) && *p != '\n' && *p != ';' &&
+             *p != ',')
+        p += 1;
 
-  return tokens;
-}
-
-void Tokenizer::split_source_to_lines() {
-  std::istringstream iss(source_code);
-  std::string line;
-
-  while (std::getline(iss, line)) {
-    source_code_lines.push_back(line);
+      const std::string_view text(word, p - word);
+      scratch.push_back(ClassifyWord(text, scratch.size()));
+    }
   }
-}
 
-void Tokenizer::generate_token_lines() {
-  for (const auto &line : source_code_lines) {
-    std::string stripped = strip_comments(line);
-    std::string normalized = normalize(stripped);
-    std::vector<std::string> string_tokens = generate_string_tokens(normalized);
-    token_lines.push_back(tokenize(string_tokens));
-  }
+  // last line without a trailing newline
+  if (!source_code.empty() && source_code.back() != '\n')
+    finish_line();
 }
 
-Tokenizer::Tokenizer(std::string source) : source_code(source) {
-  // split up the source code by new line
-  split_source_to_lines();
-
+Tokenizer::Tokenizer(std::string_view source)
+    : source_code(source.begin(), source.end()) {
   // generates token lines for the source code lines
   generate_token_lines();
 }
 
-const std::vector<std::vector<Token>> &Tokenizer::get_token_lines() const {
+const std::vector<TokenLine> &Tokenizer::get_token_lines() const {
   return token_lines;
 }
 
@@ -199,9 +138,9 @@ std::string Tokenizer::get_tokens_lines_as_string() const {
   std::ostringstream oss;
 
   size_t index = 1;
-  for (auto line : get_token_lines()) {
+  for (const auto &line : get_token_lines()) {
     oss << "LINE " << index << ": ";
-    for (auto token : line) {
+    for (const auto &token : line) {
       oss << token.as_string() << " ";
     }
     oss << "\n";
@@ -0,0 +1,44 @@
+#include "../../include/assets/font.hpp"
+
+#include <cstdlib>
+
+// one texture upload and no rasterization
+Font LoadEmbeddedFont() {
+  using namespace EmbeddedFont;
+
+  const int pixel_count = ATLAS_WIDTH * ATLAS_HEIGHT;
+
+  // raylib frees these with RL_FREE (free) in UnloadFont/UnloadImage
+  auto *pixels = static_cast<unsigned char *>(std::malloc(pixel_count * 2));
+  for (int i = 0; i < pixel_count; i += 1) {
+    pixels[i * 2] = 255;
+    pixels[i * 2 + 1] = ATLAS_ALPHA[i];
+  }
+
+  Image atlas = {pixels, ATLAS_WIDTH, ATLAS_HEIGHT, 1,
+                 PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA};
+
+  Font font = {};
+  font.baseSize = BASE_SIZE;
+  font.glyphCount = GLYPH_COUNT;
+  font.glyphPadding = GLYPH_PADDING;
+  font.texture = LoadTextureFromImage(atlas);
+  font.recs =
+      static_cast<Rectangle *>(std::calloc(GLYPH_COUNT, sizeof(Rectangle)));
+  font.glyphs =
+      static_cast<GlyphInfo *>(std::calloc(GLYPH_COUNT, sizeof(GlyphInfo)));
+
+  for (int i = 0; i < GLYPH_COUNT; i += 1) {
+    const Glyph &g = GLYPHS[i];
+    font.recs[i] = {g.x, g.y, g.width, g.height};
+    // glyph images are only needed to rebuild atlases, left empty
+    font.glyphs[i].value = g.value;
+    font.glyphs[i].offsetX = g.offset_x;
+    font.glyphs[i].offsetY = g.offset_y;
+    font.glyphs[i].advanceX = g.advance_x;
+  }
+
+  UnloadImage(atlas);
+
+  return font;
+}
@@ -0,0 +1,92 @@
+#include "../../include/audio/beeper.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+Beeper *Beeper::instance = nullptr;
+
+Beeper::Beeper(float frequency, BeeperWaveform waveform)
+    : frequency(frequency), waveform(waveform) {
+  if (instance != nullptr) {
+    throw std::runtime_error("only one beeper can be active at a time");
+  }
+
+  SetAudioStreamBufferSizeDefault(BUFFER_FRAMES);
+  stream = LoadAudioStream(SAMPLE_RATE, 16, 1);
+
+  instance = this;
+  SetAudioStreamCallback(stream, &Beeper::callback);
+  PlayAudioStream(stream);
+}
+
+Beeper::~Beeper() {
+  StopAudioStream(stream);
+  UnloadAudioStream(stream);
+  instance = nullptr;
+}
+
+void Beeper::BeginFrame() {
+  const uint64_t now = sample_clock.load(std::memory_order_acquire);
+
+  // frames follow each other back to back in sample time, unless we fell
+  // behind the audio thread or ran too far ahead of it (pause, hitches)
+  frame_origin += SAMPLES_PER_FRAME;
+  if (frame_origin < now + BUFFER_FRAMES ||
+      frame_origin > now + 4 * BUFFER_FRAMES)
+    frame_origin = now + 2 * BUFFER_FRAMES;
+}
+
+void Beeper::Schedule(uint32_t offset, bool on) {
+  const size_t h = head.load(std::memory_order_relaxed);
+  const size_t next = (h + 1) % QUEUE_SIZE;
+
+  // full, the audio thread is not consuming
+  if (next == tail.load(std::memory_order_acquire))
+    return;
+
+  queue[h] = {frame_origin + offset, on};
+  head.store(next, std::memory_order_release);
+}
+
+void Beeper::callback(void *buffer, unsigned int frames) {
+  if (instance != nullptr)
+    instance->render(static_cast<int16_t *>(buffer), frames);
+}
+
+void Beeper::render(int16_t *out, unsigned int frames) {
+  constexpr double TWO_PI = 6.283185307179586;
+  constexpr int16_t AMPLITUDE = 6000;
+
+  const double step = frequency / SAMPLE_RATE;
+  uint64_t clock = sample_clock.load(std::memory_order_relaxed);
+
+  for (unsigned int i = 0; i < frames; i += 1, clock += 1) {
+    // apply every transition due at this sample
+    size_t t = tail.load(std::memory_order_relaxed);
+    while (t != head.load(std::memory_order_acquire) &&
+           queue[t].sample <= clock) {
+      on = queue[t].on;
+      t = (t + 1) % QUEUE_SIZE;
+      tail.store(t, std::memory_order_release);
+    }
+
+    if (!on) {
+      out[i] = 0;
+      phase = 0.0;
+      continue;
+    }
+
+    if (waveform == BeeperWaveform::Square)
+      out[i] = phase < 0.5 ? AMPLITUDE : -AMPLITUDE;
+    else
+      out[i] = static_cast<int16_t>(AMPLITUDE * std::sin(TWO_PI * phase));
+
+    phase += step;
+    if (phase >= 1.0)
+      phase -= 1.0;
+  }
+
+  sample_clock.store(clock, std::memory_order_release);
+}
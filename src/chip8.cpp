@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <iomanip>
 #include <ios>
 #include <sstream>
@@ -15,78 +16,72 @@
 // ====== Constructor ======
 Chip8::Chip8() {
   // seeding
-  srand(time(nullptr));
+  Seed(static_cast<uint32_t>(time(nullptr)));
 
   // copy font to memory - (done once, and preserved)
   std::copy(fontset, fontset + FONTSET_SIZE, memory + FONTSET_START_ADDRESS);
 
-  // setup decode tables
-  for (size_t i = 0; i < 16; i += 1) {
-    table[i] = &Chip8::OP_NULL;
+  // setup the dispatch table
+  for (size_t i = 0; i < INSTRUCTION_KIND_COUNT; i += 1) {
+    handlers[i] = &Chip8::OP_NULL;
   }
 
-  table[0x0] = &Chip8::Table0;
-  table[0x1] = &Chip8::OP_1nnn;
-  table[0x2] = &Chip8::OP_2nnn;
-  table[0x3] = &Chip8::OP_3xkk;
-  table[0x4] = &Chip8::OP_4xkk;
-  table[0x5] = &Chip8::OP_5xy0;
-  table[0x6] = &Chip8::OP_6xkk;
-  table[0x7] = &Chip8::OP_7xkk;
-  table[0x8] = &Chip8::Table8;
-  table[0x9] = &Chip8::OP_9xy0;
-  table[0xA] = &Chip8::OP_Annn;
-  table[0xB] = &Chip8::OP_Bnnn;
-  table[0xC] = &Chip8::OP_Cxkk;
-  table[0xD] = &Chip8::OP_Dxyn;
-  table[0xE] = &Chip8::TableE;
-  table[0xF] = &Chip8::TableF;
-
-  // 0
-  for (size_t i = 0; i < 0xF + 1; i += 1) {
-    table0[i] = &Chip8::OP_NULL;
-  }
-  table0[0x0] = &Chip8::OP_00E0;
-  table0[0xE] = &Chip8::OP_00EE;
+  auto handle = [this](InstructionKind kind, Chip8OP op) {
+    handlers[static_cast<size_t>(kind)] = op;
+  };
+
+  handle(InstructionKind::UNKNOWN, &Chip8::OP_LOOSE);
+  handle(InstructionKind::SYS, &Chip8::OP_0nnn);
+  handle(InstructionKind::CLS, &Chip8::OP_00E0);
+  handle(InstructionKind::RET, &Chip8::OP_00EE);
+  handle(InstructionKind::JP, &Chip8::OP_1nnn);
+  handle(InstructionKind::CALL, &Chip8::OP_2nnn);
+  handle(InstructionKind::SE_BYTE, &Chip8::OP_3xkk);
+  handle(InstructionKind::SNE_BYTE, &Chip8::OP_4xkk);
+  handle(InstructionKind::SE_REG, &Chip8::OP_5xy0);
+  handle(InstructionKind::LD_BYTE, &Chip8::OP_6xkk);
+  handle(InstructionKind::ADD_BYTE, &Chip8::OP_7xkk);
+  handle(InstructionKind::LD_REG, &Chip8::OP_8xy0);
+  handle(InstructionKind::OR, &Chip8::OP_8xy1);
+  handle(InstructionKind::AND, &Chip8::OP_8xy2);
+  handle(InstructionKind::XOR, &Chip8::OP_8xy3);
+  handle(InstructionKind::ADD_REG, &Chip8::OP_8xy4);
+  handle(InstructionKind::SUB, &Chip8::OP_8xy5);
+  handle(InstructionKind::SHR, &Chip8::OP_8xy6);
+  handle(InstructionKind::SUBN, &Chip8::OP_8xy7);
+  handle(InstructionKind::SHL, &Chip8::OP_8xyE);
+  handle(InstructionKind::SNE_REG, &Chip8::OP_9xy0);
+  handle(InstructionKind::LD_I, &Chip8::OP_Annn);
+  handle(InstructionKind::JP_V0, &Chip8::OP_Bnnn);
+  handle(InstructionKind::RND, &Chip8::OP_Cxkk);
+  handle(InstructionKind::DRW, &Chip8::OP_Dxyn);
+  handle(InstructionKind::SKP, &Chip8::OP_Ex9E);
+  handle(InstructionKind::SKNP, &Chip8::OP_ExA1);
+  handle(InstructionKind::LD_FROM_DT, &Chip8::OP_Fx07);
+  handle(InstructionKind::LD_KEY, &Chip8::OP_Fx0A);
+  handle(InstructionKind::LD_DT, &Chip8::OP_Fx15);
+  handle(InstructionKind::LD_ST, &Chip8::OP_Fx18);
+  handle(InstructionKind::ADD_I, &Chip8::OP_Fx1E);
+  handle(InstructionKind::LD_FONT, &Chip8::OP_Fx29);
+  handle(InstructionKind::LD_BCD, &Chip8::OP_Fx33);
+  handle(InstructionKind::STORE, &Chip8::OP_Fx55);
+  handle(InstructionKind::LOAD, &Chip8::OP_Fx65);
 
-  // 8
-  for (size_t i = 0; i < 0xF + 1; i += 1) {
-    table8[i] = &Chip8::OP_NULL;
-  }
-
-  table8[0x0] = &Chip8::OP_8xy0;
-  table8[0x1] = &Chip8::OP_8xy1;
-  table8[0x2] = &Chip8::OP_8xy2;
-  table8[0x3] = &Chip8::OP_8xy3;
-  table8[0x4] = &Chip8::OP_8xy4;
-  table8[0x5] = &Chip8::OP_8xy5;
-  table8[0x6] = &Chip8::OP_8xy6;
-  table8[0x7] = &Chip8::OP_8xy7;
-  table8[0xE] = &Chip8::OP_8xyE;
-
-  // E
-  for (size_t i = 0; i < 0xF + 1; i += 1) {
-    tableE[i] = &Chip8::OP_NULL;
-  }
-  tableE[0xE] = &Chip8::OP_Ex9E;
-  tableE[0x1] = &Chip8::OP_ExA1;
+  if (allow_custom_instructions)
+    handle(InstructionKind::HALT, &Chip8::OP_FxFF);
+}
 
-  // F
-  for (size_t i = 0; i < 0xFF + 1; i += 1) {
-    tableF[i] = &Chip8::OP_NULL;
-  }
-  tableF[0x07] = &Chip8::OP_Fx07;
-  tableF[0x0A] = &Chip8::OP_Fx0A;
-  tableF[0x15] = &Chip8::OP_Fx15;
-  tableF[0x18] = &Chip8::OP_Fx18;
-  tableF[0x1E] = &Chip8::OP_Fx1E;
-  tableF[0x29] = &Chip8::OP_Fx29;
-  tableF[0x33] = &Chip8::OP_Fx33;
-  tableF[0x55] = &Chip8::OP_Fx55;
-  tableF[0x65] = &Chip8::OP_Fx65;
+// ====== Random ======
+void Chip8::Seed(uint32_t seed) {
+  // xorshift must never be all zero
+  rng_state = seed ? seed : 0x9E3779B9u;
+}
 
-  if (allow_custom_instructions)
-    tableF[0xFF] = &Chip8::OP_FxFF; // HALT
+uint8_t Chip8::NextRandomByte() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return static_cast<uint8_t>(rng_state >> 24);
 }
 
 // ====== Loaders ======
@@ -122,11 +117,16 @@ void Chip8::Reset() {
   delay = {};
   sound = {};
 
+  cycles = {};
+  sound_events_count = {};
+
   std::fill(video, video + VIDEO_WIDTH * VIDEO_HEIGHT, 0);
 
   opcode = {};
 
   std::fill(keypad, keypad + 16, 0);
+  key_events_head = {};
+  key_events_count = {};
 
   rom = {};
 }
@@ -135,8 +135,9 @@ void Chip8::Reset() {
 void Chip8::Fetch() { opcode = (memory[pc] << 8u) | memory[pc + 1]; }
 
 void Chip8::DecodeAndExecute() {
-  // decode the opcode and execute the right instruction from table (future)
-  (this->*(table[(opcode & 0xF000u) >> 12u]))();
+  // decode the opcode and execute the right instruction from table
+  instruction = DecodeInstruction(opcode);
+  (this->*(handlers[static_cast<size_t>(instruction.kind)]))();
 }
 
 void Chip8::Cycle() {
@@ -144,6 +145,10 @@ void Chip8::Cycle() {
   if (halted && allow_custom_instructions)
     return;
 
+  // key transitions due at this cycle
+  if (key_events_count > 0)
+    ApplyKeyEvents();
+
   // fetch opcode from memory
   Fetch();
 
@@ -154,14 +159,125 @@ void Chip8::Cycle() {
 
   // decode execute current opcode
   DecodeAndExecute();
+
+  cycles += 1;
 }
 
 void Chip8::UpdateTimers() {
   if (delay > 0)
     delay -= 1;
 
-  if (sound > 0)
+  if (sound > 0) {
     sound -= 1;
+    if (sound == 0)
+      PushSoundEvent(false);
+  }
+}
+
+// ====== Input ======
+void Chip8::QueueKeyEvent(uint64_t cycle, uint8_t key, bool down) {
+  // queue is full, apply the oldest transition now rather than losing it
+  if (key_events_count == KEY_EVENTS_CAPACITY) {
+    const KeyEvent &oldest = key_events[key_events_head];
+    keypad[oldest.key] = oldest.down;
+    key_events_head = (key_events_head + 1) % KEY_EVENTS_CAPACITY;
+    key_events_count -= 1;
+  }
+
+  const size_t tail =
+      (key_events_head + key_events_count) % KEY_EVENTS_CAPACITY;
+  key_events[tail] = {cycle, static_cast<uint8_t>(key & 0xFu), down};
+  key_events_count += 1;
+}
+
+void Chip8::ApplyKeyEvents() {
+  while (key_events_count > 0 && key_events[key_events_head].cycle <= cycles) {
+    const KeyEvent &event = key_events[key_events_head];
+    keypad[event.key] = event.down ? 1 : 0;
+
+    key_events_head = (key_events_head + 1) % KEY_EVENTS_CAPACITY;
+    key_events_count -= 1;
+  }
+}
+
+// ====== Sound ======
+void Chip8::SetSoundTimer(uint8_t value) {
+  const bool was_on = sound > 0;
+  sound = value;
+
+  if (was_on != (sound > 0))
+    PushSoundEvent(sound > 0);
+}
+
+void Chip8::PushSoundEvent(bool on) {
+  // nobody is draining (e.g. running headless), keep the latest state only
+  if (sound_events_count == SOUND_EVENTS_CAPACITY)
+    sound_events_count -= 1;
+
+  sound_events[sound_events_count] = {cycles, on};
+  sound_events_count += 1;
+}
+
+void Chip8::RunFrame(int cycles_per_frame) {
+  for (int i = 0; i < cycles_per_frame; i += 1) {
+    Cycle();
+  }
+
+  UpdateTimers();
+}
+
+// ====== Save states ======
+void Chip8::SaveState(State &state) const {
+  std::copy(memory, memory + 4096, state.memory);
+  std::copy(V, V + 16, state.V);
+  state.sp = sp;
+  state.pc = pc;
+  state.index = index;
+  std::copy(stack, stack + 16, state.stack);
+  state.delay = delay;
+  state.sound = sound;
+  state.cycles = cycles;
+  state.rng_state = rng_state;
+  std::copy(video, video + VIDEO_WIDTH * VIDEO_HEIGHT, state.video);
+  state.opcode = opcode;
+  std::copy(keypad, keypad + 16, state.keypad);
+  state.halted = halted;
+  std::copy(key_events, key_events + KEY_EVENTS_CAPACITY, state.key_events);
+  state.key_events_head = key_events_head;
+  state.key_events_count = key_events_count;
+  std::copy(sound_events, sound_events + SOUND_EVENTS_CAPACITY,
+            state.sound_events);
+  state.sound_events_count = sound_events_count;
+}
+
+void Chip8::LoadState(const State &state) {
+  std::copy(state.memory, state.memory + 4096, memory);
+  std::copy(state.V, state.V + 16, V);
+  sp = state.sp;
+  pc = state.pc;
+  index = state.index;
+  std::copy(state.stack, state.stack + 16, stack);
+  delay = state.delay;
+  sound = state.sound;
+  cycles = state.cycles;
+  rng_state = state.rng_state;
+  std::copy(state.video, state.video + VIDEO_WIDTH * VIDEO_HEIGHT, video);
+  opcode = state.opcode;
+  std::copy(state.keypad, state.keypad + 16, keypad);
+  halted = state.halted;
+  std::copy(state.key_events, state.key_events + KEY_EVENTS_CAPACITY,
+            key_events);
+  key_events_head = state.key_events_head;
+  key_events_count = state.key_events_count;
+  std::copy(state.sound_events, state.sound_events + SOUND_EVENTS_CAPACITY,
+            sound_events);
+  sound_events_count = state.sound_events_count;
+}
+
+void Chip8::AllowCustomInstructions(bool allow) {
+  allow_custom_instructions = allow;
+  handlers[static_cast<size_t>(InstructionKind::HALT)] =
+      allow ? &Chip8::OP_FxFF : &Chip8::OP_NULL;
 }
 
 bool Chip8::RunTillHalt() {
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../include/debug/debug_info.hpp"
+
+static constexpr uint32_t DEBUG_INFO_VERSION = 2;
+static constexpr char DEBUG_INFO_MAGIC[4] = {'C', '8', 'D', 'B'};
+
+// record sizes in bytes, see the layout in debug_info.hpp
+static constexpr size_t HEADER_SIZE = 4 + 6 * 4 + 8;
+static constexpr size_t LINE_SIZE = 7 * 4;
+static constexpr size_t SYMBOL_SIZE = 3 * 4;
+static constexpr size_t FILE_SIZE = 2 * 4;
+
+static uint32_t u32_at(const uint8_t *p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void put_u32(std::vector<uint8_t> &out, uint32_t value) {
+  for (int i = 0; i < 4; i += 1)
+    out.push_back((value >> (8 * i)) & 0xFFu);
+}
+
+static uint64_t u64_at(const uint8_t *p) {
+  return u32_at(p) | (static_cast<uint64_t>(u32_at(p + 4)) << 32);
+}
+
+static void put_u64(std::vector<uint8_t> &out, uint64_t value) {
+  put_u32(out, static_cast<uint32_t>(value));
+  put_u32(out, static_cast<uint32_t>(value >> 32));
+}
+
+// FNV-1a
+static uint64_t hash_rom(const uint8_t *rom, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; i += 1) {
+    hash ^= rom[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// ====== Writing ======
+static std::vector<std::string_view> split_lines(std::string_view s) {
+  std::vector<std::string_view> lines;
+  while (!s.empty()) {
+    const size_t end = std::min(s.find('\n'), s.size());
+    std::string_view line = s.substr(0, end);
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    lines.push_back(line);
+    s.remove_prefix(std::min(end + 1, s.size()));
+  }
+  return lines;
+}
+
+void WriteDebugInfo(const std::string &path, const std::vector<uint8_t> &rom,
+                    const std::vector<std::string> &files,
+                    std::vector<DebugLine> lines,
+                    const std::unordered_map<std::string, uint16_t> &symbols) {
+  std::sort(lines.begin(), lines.end(),
+            [](const DebugLine &a, const DebugLine &b) {
+              return a.address < b.address;
+            });
+
+  std::vector<std::pair<uint16_t, std::string_view>> sorted_symbols;
+  for (const auto &[name, addr] : symbols)
+    sorted_symbols.emplace_back(addr, name);
+  std::sort(sorted_symbols.begin(), sorted_symbols.end());
+
+  std::string strings;
+  auto add_string = [&strings](std::string_view s) {
+    const auto offset = static_cast<uint32_t>(strings.size());
+    strings.append(s.data(), s.size());
+    return std::make_pair(offset, static_cast<uint32_t>(s.size()));
+  };
+
+  // ====== Records ======
+  std::vector<uint8_t> file_records;
+  std::vector<std::string> sources(files.size());
+  std::vector<std::vector<std::string_view>> source_lines(files.size());
+  for (size_t f = 0; f < files.size(); f += 1) {
+    const auto [offset, length] = add_string(files[f]);
+    put_u32(file_records, offset);
+    put_u32(file_records, length);
+
+    std::ifstream file(files[f], std::ios::binary);
+    if (file) {
+      sources[f].assign(std::istreambuf_iterator<char>(file), {});
+      source_lines[f] = split_lines(sources[f]);
+    }
+  }
+
+  std::vector<uint8_t> symbol_records;
+  // first symbol at each address, 1-based
+  std::unordered_map<uint16_t, uint32_t> symbol_at;
+  for (size_t s = 0; s < sorted_symbols.size(); s += 1) {
+    const auto [addr, name] = sorted_symbols[s];
+    const auto [offset, length] = add_string(name);
+    put_u32(symbol_records, addr);
+    put_u32(symbol_records, offset);
+    put_u32(symbol_records, length);
+    symbol_at.emplace(addr, static_cast<uint32_t>(s + 1));
+  }
+
+  std::vector<uint8_t> line_records;
+  const size_t rom_size = rom.size();
+  std::vector<uint32_t> index(rom_size, 0);
+  for (size_t l = 0; l < lines.size(); l += 1) {
+    const DebugLine &line = lines[l];
+
+    std::string_view text;
+    if (line.file < source_lines.size() && line.line >= 1 &&
+        line.line <= source_lines[line.file].size())
+      text = source_lines[line.file][line.line - 1];
+    const auto [offset, length] = add_string(text);
+
+    const auto symbol = symbol_at.find(line.address);
+
+    put_u32(line_records, line.address);
+    put_u32(line_records, line.size);
+    put_u32(line_records, line.file);
+    put_u32(line_records, line.line);
+    put_u32(line_records, offset);
+    put_u32(line_records, length);
+    put_u32(line_records, symbol == symbol_at.end() ? 0 : symbol->second);
+
+    for (size_t b = 0; b < line.size; b += 1) {
+      const size_t at = line.address - 0x200 + b;
+      if (line.address >= 0x200 && at < rom_size)
+        index[at] = static_cast<uint32_t>(l + 1);
+    }
+  }
+
+  // ====== File ======
+  std::vector<uint8_t> out(DEBUG_INFO_MAGIC,
+                           DEBUG_INFO_MAGIC + sizeof(DEBUG_INFO_MAGIC));
+  put_u32(out, DEBUG_INFO_VERSION);
+  put_u32(out, rom_size);
+  put_u32(out, lines.size());
+  put_u32(out, sorted_symbols.size());
+  put_u32(out, files.size());
+  put_u32(out, strings.size());
+  put_u64(out, hash_rom(rom.data(), rom.size()));
+  for (uint32_t entry : index)
+    put_u32(out, entry);
+  out.insert(out.end(), line_records.begin(), line_records.end());
+  out.insert(out.end(), symbol_records.begin(), symbol_records.end());
+  out.insert(out.end(), file_records.begin(), file_records.end());
+  out.insert(out.end(), strings.begin(), strings.end());
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open file for writing: " + path);
+  }
+
+  file.write(reinterpret_cast<const char *>(out.data()), out.size());
+  if (!file) {
+    throw std::runtime_error("failed to write data to file: " + path);
+  }
+}
+
+// ====== Reading ======
+DebugInfo::DebugInfo(const std::string &path) : mapping(path) {
+  const uint8_t *data = mapping.data();
+  const size_t size = mapping.size();
+
+  if (size < HEADER_SIZE ||
+      std::memcmp(data, DEBUG_INFO_MAGIC, sizeof(DEBUG_INFO_MAGIC)) != 0)
+    throw std::runtime_error("not a debug info file: " + path);
+  if (u32_at(data + 4) != DEBUG_INFO_VERSION)
+    throw std::runtime_error("debug info version mismatch: " + path);
+
+  rom_size = u32_at(data + 8);
+  line_count = u32_at(data + 12);
+  symbol_count = u32_at(data + 16);
+  file_count = u32_at(data + 20);
+  strings_size = u32_at(data + 24);
+  rom_hash = u64_at(data + 28);
+
+  const uint64_t expected =
+      HEADER_SIZE + 4ull * rom_size + uint64_t{LINE_SIZE} * line_count +
+      uint64_t{SYMBOL_SIZE} * symbol_count + uint64_t{FILE_SIZE} * file_count +
+      strings_size;
+  if (expected != size)
+    throw std::runtime_error("corrupt debug info: " + path);
+
+  index = data + HEADER_SIZE;
+  lines = index + 4 * size_t{rom_size};
+  symbols = lines + LINE_SIZE * line_count;
+  files = symbols + SYMBOL_SIZE * symbol_count;
+  strings = reinterpret_cast<const char *>(files + FILE_SIZE * file_count);
+
+  // checked once here, so lookups can trust every offset
+  try {
+    validate();
+  } catch (const std::exception &e) {
+    throw std::runtime_error(std::string(e.what()) + ": " + path);
+  }
+}
+
+void DebugInfo::validate() const {
+  for (uint32_t i = 0; i < rom_size; i += 1) {
+    if (u32_at(index + 4 * size_t{i}) > line_count)
+      throw std::runtime_error("corrupt debug info index");
+  }
+
+  auto check_string = [this](const uint8_t *record) {
+    const uint64_t end = uint64_t{u32_at(record)} + u32_at(record + 4);
+    if (end > strings_size)
+      throw std::runtime_error("corrupt debug info string");
+  };
+
+  for (uint32_t i = 0; i < line_count; i += 1) {
+    const uint8_t *record = lines + LINE_SIZE * i;
+    if (u32_at(record + 8) >= file_count ||
+        u32_at(record + 24) > symbol_count)
+      throw std::runtime_error("corrupt debug info line");
+    check_string(record + 16);
+  }
+  for (uint32_t i = 0; i < symbol_count; i += 1)
+    check_string(symbols + SYMBOL_SIZE * i + 4);
+  for (uint32_t i = 0; i < file_count; i += 1)
+    check_string(files + FILE_SIZE * i);
+}
+
+std::string_view DebugInfo::string_at(const uint8_t *record) const {
+  return {strings + u32_at(record), u32_at(record + 4)};
+}
+
+// ====== Lookups ======
+size_t DebugInfo::LineAt(uint16_t addr) const {
+  if (addr < 0x200 || addr - 0x200u >= rom_size)
+    return NO_LINE;
+
+  const uint32_t entry = u32_at(index + 4 * size_t{addr - 0x200u});
+  return entry == 0 ? NO_LINE : entry - 1;
+}
+
+DebugInfo::Line DebugInfo::GetLine(size_t i) const {
+  const uint8_t *record = lines + LINE_SIZE * i;
+
+  Line line;
+  line.address = static_cast<uint16_t>(u32_at(record));
+  line.size = static_cast<uint16_t>(u32_at(record + 4));
+  line.file = string_at(files + FILE_SIZE * u32_at(record + 8));
+  line.line = u32_at(record + 12);
+  line.text = string_at(record + 16);
+
+  const uint32_t symbol = u32_at(record + 24);
+  if (symbol != 0)
+    line.label = string_at(symbols + SYMBOL_SIZE * (symbol - 1) + 4);
+  return line;
+}
+
+std::string_view DebugInfo::LabelBefore(uint16_t addr) const {
+  // symbols are sorted by address
+  uint32_t lo = 0, hi = symbol_count;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (u32_at(symbols + SYMBOL_SIZE * mid) <= addr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo == 0)
+    return {};
+  return string_at(symbols + SYMBOL_SIZE * (lo - 1) + 4);
+}
+
+bool DebugInfo::MatchesRom(const uint8_t *rom, size_t size) const {
+  return size == rom_size && hash_rom(rom, size) == rom_hash;
+}
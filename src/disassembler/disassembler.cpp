@@ -1,208 +1,425 @@
 #include "../../include/disassembler/disassembler.hpp"
+#include "../../include/disassembler/flow_analysis.hpp"
+#include "../../include/instruction.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
+#include <memory>
+#include <string>
 #include <vector>
 
-std::string Disassembler::Decode(uint16_t opcode) {
+// ====== Tables ======
+// lowercase for operands, uppercase for the opcode of an unknown instruction
+static constexpr char HEX_DIGITS[] = "0123456789abcdef0123456789ABCDEF";
+static constexpr uint8_t UPPER_HEX = 16;
 
-  std::ostringstream out;
-
-  uint8_t first_nibble = (opcode & 0xF000u) >> 12u;
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
-  uint8_t n = (opcode & 0x000Fu);
-  uint8_t kk = (opcode & 0x00FFu);
-  uint16_t nnn = (opcode & 0x0FFFu);
-
-  switch (first_nibble) {
-  case 0x0:
-    if (opcode == 0x00E0)
-      out << "CLS";
-    else if (opcode == 0x00EE)
-      out << "RET";
-    else
-      out << "SYS 0x" << std::hex << nnn;
-    break;
-
-  case 0x1:
-    out << "JP 0x" << std::hex << nnn;
-    break;
-
-  case 0x2:
-    out << "CALL 0x" << std::hex << nnn;
-    break;
-
-  case 0x3:
-    out << "SE V" << std::hex << +x << ", 0x" << +kk;
-    break;
-
-  case 0x4:
-    out << "SNE V" << std::hex << +x << ", 0x" << +kk;
-    break;
-
-  case 0x5:
-    if (n == 0x0)
-      out << "SE V" << std::hex << +x << ", V" << +y;
-    else
-      out << "??? (" << std::hex << std::uppercase << opcode << ")";
-    break;
-
-  case 0x6:
-    out << "LD V" << std::hex << +x << ", 0x" << +kk;
-    break;
-
-  case 0x7:
-    out << "ADD V" << std::hex << +x << ", 0x" << +kk;
-    break;
-
-  case 0x8:
-    switch (n) {
-    case 0x0:
-      out << "LD V" << std::hex << +x << ", V" << +y;
-      break;
-    case 0x1:
-      out << "OR V" << std::hex << +x << ", V" << +y;
-      break;
-    case 0x2:
-      out << "AND V" << std::hex << +x << ", V" << +y;
-      break;
-    case 0x3:
-      out << "XOR V" << std::hex << +x << ", V" << +y;
-      break;
-    case 0x4:
-      out << "ADD V" << std::hex << +x << ", V" << +y;
-      break;
-    case 0x5:
-      out << "SUB V" << std::hex << +x << ", V" << +y;
-      break;
-    case 0x6:
-      out << "SHR V" << std::hex << +x;
-      break;
-    case 0x7:
-      out << "SUBN V" << std::hex << +x << ", V" << +y;
-      break;
-    case 0xE:
-      out << "SHL V" << std::hex << +x;
-      break;
-    default:
-      out << "??? (" << std::hex << std::uppercase << opcode << ")";
-      break;
+// Slots of a form that does not use them point past the text, so decoding
+// writes every slot unconditionally.
+static constexpr uint8_t SCRATCH = Disassembler::MAX_DECODED_LENGTH - 1;
+
+// The text of one instruction form, laid out ahead of time: fixed text
+// with one-digit slots for x, y and n, then at most one number of varying
+// width and a closing character. "%x", "%y" and "%n" in a pattern are the
+// slots, "%k", "%a" and "%o" the kk, nnn and whole opcode tails.
+struct Format {
+  char text[16];
+  uint8_t length;
+  uint8_t x_at;
+  uint8_t y_at;
+  uint8_t n_at;
+  uint16_t tail_mask;  // bits of the opcode in the tail, 0 for none
+  uint8_t tail_digits; // offset into HEX_DIGITS
+  uint8_t closed;      // 1 when the text ends in ')' after the tail
+};
+
+static constexpr Format make_format(const char *pattern) {
+  Format format{{}, 0, SCRATCH, SCRATCH, SCRATCH, 0, 0, 0};
+  uint8_t length = 0;
+  for (const char *p = pattern; *p != '\0'; p += 1) {
+    if (*p != '%') {
+      format.text[length++] = *p;
+      continue;
     }
-    break;
-
-  case 0x9:
-    if (n == 0x0)
-      out << "SNE V" << std::hex << +x << ", V" << +y;
-    else
-      out << "??? (" << std::hex << std::uppercase << opcode << ")";
-    break;
-
-  case 0xA:
-    out << "LD I, 0x" << std::hex << nnn;
-    break;
-
-  case 0xB:
-    out << "JP V0, 0x" << std::hex << nnn;
-    break;
-
-  case 0xC:
-    out << "RND V" << std::hex << +x << ", 0x" << +kk;
-    break;
-
-  case 0xD:
-    out << "DRW V" << std::hex << +x << ", V" << +y << ", 0x" << +n;
-    break;
-
-  case 0xE:
-    if (kk == 0x9E)
-      out << "SKP V" << std::hex << +x;
-    else if (kk == 0xA1)
-      out << "SKNP V" << std::hex << +x;
-    else
-      out << "??? (" << std::hex << std::uppercase << opcode << ")";
-    break;
-
-  case 0xF:
-    switch (kk) {
-    case 0x07:
-      out << "LD V" << std::hex << +x << ", DT";
-      break;
-    case 0x0A:
-      out << "LD V" << std::hex << +x << ", K";
-      break;
-    case 0x15:
-      out << "LD DT, V" << std::hex << +x;
-      break;
-    case 0x18:
-      out << "LD ST, V" << std::hex << +x;
-      break;
-    case 0x1E:
-      out << "ADD I, V" << std::hex << +x;
+
+    p += 1;
+    switch (*p) {
+    case 'x':
+      format.x_at = length;
+      format.text[length++] = '0';
       break;
-    case 0x29:
-      out << "LD F, V" << std::hex << +x;
+    case 'y':
+      format.y_at = length;
+      format.text[length++] = '0';
       break;
-    case 0x33:
-      out << "LD B, V" << std::hex << +x;
+    case 'n':
+      format.n_at = length;
+      format.text[length++] = '0';
       break;
-    case 0x55:
-      out << "LD [I], V" << std::hex << +x;
+    case 'k':
+      format.tail_mask = 0x00FF;
       break;
-    case 0x65:
-      out << "LD V" << std::hex << +x << ", [I]";
+    case 'a':
+      format.tail_mask = 0x0FFF;
       break;
     default:
-      out << "??? (" << std::hex << std::uppercase << opcode << ")";
+      format.tail_mask = 0xFFFF;
+      format.tail_digits = UPPER_HEX;
+      format.closed = 1;
       break;
     }
-    break;
+  }
+  format.length = length;
+  return format;
+}
+
+// indexed by InstructionKind; HALT is ch8emu's own and lists as unknown
+static constexpr Format FORMATS[] = {
+    make_format("CLS"),
+    make_format("RET"),
+    make_format("SYS 0x%a"),
+    make_format("JP 0x%a"),
+    make_format("CALL 0x%a"),
+    make_format("SE V%x, 0x%k"),
+    make_format("SNE V%x, 0x%k"),
+    make_format("SE V%x, V%y"),
+    make_format("LD V%x, 0x%k"),
+    make_format("ADD V%x, 0x%k"),
+    make_format("LD V%x, V%y"),
+    make_format("OR V%x, V%y"),
+    make_format("AND V%x, V%y"),
+    make_format("XOR V%x, V%y"),
+    make_format("ADD V%x, V%y"),
+    make_format("SUB V%x, V%y"),
+    make_format("SHR V%x"),
+    make_format("SUBN V%x, V%y"),
+    make_format("SHL V%x"),
+    make_format("SNE V%x, V%y"),
+    make_format("LD I, 0x%a"),
+    make_format("JP V0, 0x%a"),
+    make_format("RND V%x, 0x%k"),
+    make_format("DRW V%x, V%y, 0x%n"),
+    make_format("SKP V%x"),
+    make_format("SKNP V%x"),
+    make_format("LD V%x, DT"),
+    make_format("LD V%x, K"),
+    make_format("LD DT, V%x"),
+    make_format("LD ST, V%x"),
+    make_format("ADD I, V%x"),
+    make_format("LD F, V%x"),
+    make_format("LD B, V%x"),
+    make_format("LD [I], V%x"),
+    make_format("LD V%x, [I]"),
+    make_format("??? (%o"),
+    make_format("??? (%o"),
+};
+static_assert(sizeof(FORMATS) / sizeof(FORMATS[0]) == INSTRUCTION_KIND_COUNT);
+
+// significant hex digits of value, at least four
+static size_t hex_width(uint64_t value) {
+  size_t width = 4;
+  while (width < 16 && (value >> (4 * width)) != 0)
+    width += 1;
+  return width;
+}
+
+static size_t put_hex(char *out, uint64_t value, size_t width) {
+  if (width == 4) {
+    out[0] = HEX_DIGITS[(value >> 12u) & 0xFu];
+    out[1] = HEX_DIGITS[(value >> 8u) & 0xFu];
+    out[2] = HEX_DIGITS[(value >> 4u) & 0xFu];
+    out[3] = HEX_DIGITS[value & 0xFu];
+    return 4;
+  }
+
+  for (size_t i = width; i > 0; i -= 1, value >>= 4)
+    out[i - 1] = HEX_DIGITS[value & 0xFu];
+  return width;
+}
+
+// ====== Decoding ======
+static size_t put_instruction_text(const Instruction &instruction,
+                                   char *out) {
+  const uint16_t opcode = instruction.opcode;
+  const Format &format = FORMATS[static_cast<size_t>(instruction.kind)];
+  std::memcpy(out, format.text, sizeof(format.text));
+  out[format.x_at] = HEX_DIGITS[(opcode & 0x0F00u) >> 8u];
+  out[format.y_at] = HEX_DIGITS[(opcode & 0x00F0u) >> 4u];
+  out[format.n_at] = HEX_DIGITS[opcode & 0x000Fu];
+
+  // the tail without leading zeros: its digits are shifted to the top of
+  // 16 bits and all four written, the length keeps the significant ones
+  const unsigned tail = opcode & format.tail_mask;
+  const unsigned width =
+      (format.tail_mask != 0) *
+      (1u + (tail > 0xFu) + (tail > 0xFFu) + (tail > 0xFFFu));
+  const unsigned aligned = tail << (4u * (4u - width));
+  const char *digits = HEX_DIGITS + format.tail_digits;
+
+  char *end = out + format.length;
+  end[0] = digits[(aligned >> 12u) & 0xFu];
+  end[1] = digits[(aligned >> 8u) & 0xFu];
+  end[2] = digits[(aligned >> 4u) & 0xFu];
+  end[3] = digits[aligned & 0xFu];
+  end[width] = ')';
+  return format.length + width + format.closed;
+}
+
+size_t Disassembler::Decode(uint16_t opcode, char *out) {
+  return put_instruction_text(DecodeInstruction(opcode), out);
+}
+
+static size_t put_line(size_t address, const Instruction &instruction,
+                       bool verbose, char *out) {
+  const uint16_t opcode = instruction.opcode;
+  size_t length = 0;
+  if (verbose) {
+    // ROM addresses take four digits, only huge inputs need the loop
+    length += put_hex(out, address,
+                      address <= 0xFFFF ? 4 : hex_width(address));
+    out[length++] = ':';
+    out[length++] = ' ';
+    length += put_hex(out + length, opcode, 4);
+    out[length++] = ' ';
+    out[length++] = ' ';
+  }
+  length += put_instruction_text(instruction, out + length);
+  out[length++] = '\n';
+  return length;
+}
+
+size_t Disassembler::DecodeLine(size_t address, uint16_t opcode, bool verbose,
+                                char *out) {
+  return put_line(address, DecodeInstruction(opcode), verbose, out);
+}
+
+std::string Disassembler::Decode(uint16_t opcode) {
+  char text[MAX_DECODED_LENGTH];
+  return std::string(text, Disassembler::Decode(opcode, text));
+}
+
+// ====== Streaming ======
+// The listing of one streaming call, handed to the sink whenever the next
+// line might not fit.
+class SinkBuffer {
+public:
+  SinkBuffer(const Disassembler::Sink &sink, size_t capacity)
+      : sink(sink), capacity(capacity), buffer(new char[capacity]) {}
 
+  // room for a line of up to `length` chars
+  char *Reserve(size_t length) {
+    if (capacity - used < length)
+      Flush();
+    return buffer.get() + used;
+  }
+  void Commit(size_t length) { used += length; }
+
+  void Flush() {
+    if (used != 0)
+      sink(buffer.get(), used);
+    used = 0;
+  }
+
+private:
+  const Disassembler::Sink &sink;
+  size_t capacity;
+  std::unique_ptr<char[]> buffer;
+  size_t used = 0;
+};
+
+// small ROMs only get what their listing can fill
+static size_t stream_capacity(size_t rom_size, size_t line_length) {
+  return std::min(Disassembler::STREAM_BUFFER_SIZE,
+                  (rom_size / 2 + 1) * line_length);
+}
+
+void Disassembler::DecodeRom(const uint8_t *rom, size_t size, bool verbose,
+                             const Sink &sink) {
+  SinkBuffer out(sink, stream_capacity(size, MAX_LINE_LENGTH));
+
+  // decoded a block at a time, then formatted
+  constexpr size_t BLOCK = 256;
+  Instruction block[BLOCK];
+
+  const size_t count = size / 2;
+  for (size_t start = 0; start < count; start += BLOCK) {
+    const size_t decoded = std::min(BLOCK, count - start);
+    DecodeInstructions(rom + 2 * start, decoded, block);
+
+    for (size_t i = 0; i < decoded; i += 1) {
+      const size_t address = 2 * (start + i) + 0x200;
+      out.Commit(
+          put_line(address, block[i], verbose, out.Reserve(MAX_LINE_LENGTH)));
+    }
+  }
+  out.Flush();
+}
+
+// ====== Flow-following listing ======
+// a label, an instruction or eight data bytes, with their comment
+static constexpr size_t FLOW_LINE_LENGTH = 128;
+// where the comment of a line starts
+static constexpr size_t COMMENT_COLUMN = 28;
+static constexpr size_t DATA_PER_LINE = 8;
+
+static size_t put_text(char *out, const char *text) {
+  const size_t length = std::strlen(text);
+  std::memcpy(out, text, length);
+  return length;
+}
+
+// sub_2a4 for subroutines, L_2a4 for other code and data_2a4 for the rest
+static size_t put_label(char *out, size_t offset, const FlowAnalysis &flow) {
+  size_t length = put_text(out, flow.IsCallTarget(offset)    ? "sub_"
+                                : flow.IsInstruction(offset) ? "L_"
+                                                             : "data_");
+  const size_t addr = offset + 0x200;
+  return length + put_hex(out + length, addr, addr <= 0xFFF ? 3 : 4);
+}
+
+static size_t put_byte(char *out, uint8_t byte) {
+  out[0] = '0';
+  out[1] = 'x';
+  out[2] = HEX_DIGITS[byte >> 4u];
+  out[3] = HEX_DIGITS[byte & 0xFu];
+  return 4;
+}
+
+// `.byte 0x12, 0x34`
+static size_t put_bytes(char *out, const uint8_t *bytes, size_t count) {
+  size_t length = put_text(out, ".byte ");
+  for (size_t i = 0; i < count; i += 1) {
+    if (i != 0)
+      length += put_text(out + length, ", ");
+    length += put_byte(out + length, bytes[i]);
+  }
+  return length;
+}
+
+// ch8asm has no SYS, and its SHR and SHL always encode y = 0
+static bool is_assemblable(const Instruction &instruction) {
+  switch (instruction.kind) {
+  case InstructionKind::SHR:
+  case InstructionKind::SHL:
+    return instruction.y == 0;
+  case InstructionKind::SYS:
+  case InstructionKind::HALT:
+  case InstructionKind::UNKNOWN:
+    return false;
   default:
-    out << "??? (" << std::hex << std::uppercase << opcode << ")";
-    break;
+    return true;
   }
-  return out.str();
 }
 
-std::string Disassembler::DecodeRomFromArray(std::vector<uint8_t> rom,
-                                             bool verbose) {
-  std::ostringstream out;
+// the text of an assemblable opcode, naming its target when it has a label
+static size_t put_instruction(char *out, const Instruction &instruction,
+                              const FlowAnalysis &flow) {
+  const uint16_t addr = instruction.nnn;
+  if (!HasAddress(instruction.kind) || addr < 0x200 ||
+      !flow.IsLabel(addr - 0x200u))
+    return put_instruction_text(instruction, out);
 
-  for (size_t i = 0; i + 1 < rom.size(); i += 2) {
-    uint16_t opcode = (rom[i] << 8u) | rom[i + 1];
+  // the fixed text up to its "0x"
+  const Format &format = FORMATS[static_cast<size_t>(instruction.kind)];
+  const size_t length = format.length - 2;
+  std::memcpy(out, format.text, length);
+  return length + put_label(out + length, addr - 0x200u, flow);
+}
+
+void Disassembler::DecodeRomFollowingFlow(const uint8_t *rom, size_t size,
+                                          bool verbose, const Sink &sink) {
+  const FlowAnalysis flow(rom, size);
+  SinkBuffer out(sink, stream_capacity(size, FLOW_LINE_LENGTH));
+
+  for (size_t pc = 0; pc < size;) {
+    if (flow.IsLabel(pc)) {
+      char *line = out.Reserve(FLOW_LINE_LENGTH);
+      size_t length = put_label(line, pc, flow);
+      line[length++] = ':';
+      line[length++] = '\n';
+      out.Commit(length);
+    }
+
+    char *line = out.Reserve(FLOW_LINE_LENGTH);
+    size_t length = put_text(line, "    ");
+    size_t count;
+    // shown after the code when it does not say everything
+    char comment[MAX_DECODED_LENGTH];
+    size_t comment_length = 0;
 
-    if (verbose)
-      out << std::setw(4) << std::setfill('0') << std::hex << i + 0x200 << ": "
-          << std::setw(4) << opcode << "  " << Disassembler::Decode(opcode)
-          << "\n";
-    else
-      out << Disassembler::Decode(opcode) << "\n";
+    if (flow.IsInstruction(pc)) {
+      const Instruction instruction =
+          DecodeInstruction((rom[pc] << 8u) | rom[pc + 1]);
+      count = 2;
+      if (is_assemblable(instruction)) {
+        length += put_instruction(line + length, instruction, flow);
+      } else {
+        length += put_bytes(line + length, rom + pc, 2);
+        comment_length = put_instruction_text(instruction, comment);
+      }
+    } else {
+      // data runs up to the next instruction or label
+      count = 1;
+      while (pc + count < size && count < DATA_PER_LINE &&
+             !flow.IsInstruction(pc + count) && !flow.IsLabel(pc + count))
+        count += 1;
+      length += put_bytes(line + length, rom + pc, count);
+    }
+
+    if (verbose || comment_length != 0) {
+      while (length < COMMENT_COLUMN)
+        line[length++] = ' ';
+      length += put_text(line + length, " ;");
+      if (verbose) {
+        line[length++] = ' ';
+        const size_t addr = pc + 0x200;
+        length +=
+            put_hex(line + length, addr, addr <= 0xFFFF ? 4 : hex_width(addr));
+        if (flow.IsInstruction(pc)) {
+          line[length++] = ':';
+          line[length++] = ' ';
+          length += put_hex(line + length, (rom[pc] << 8u) | rom[pc + 1], 4);
+        }
+      }
+      if (comment_length != 0) {
+        line[length++] = ' ';
+        std::memcpy(line + length, comment, comment_length);
+        length += comment_length;
+      }
+    }
+
+    line[length++] = '\n';
+    out.Commit(length);
+    pc += count;
   }
+  out.Flush();
+}
 
-  return out.str();
+std::string Disassembler::DecodeRomFromArray(const std::vector<uint8_t> &rom,
+                                             bool verbose) {
+  std::string out;
+  // an average line, so most ROMs never grow the string
+  out.reserve(rom.size() / 2 * (verbose ? 26 : 14));
+
+  Disassembler::DecodeRom(rom.data(), rom.size(), verbose,
+                          [&out](const char *text, size_t length) {
+                            out.append(text, length);
+                          });
+  return out;
 }
 
 std::vector<std::string>
-Disassembler::DecodeRomFromArrayAsVector(std::vector<uint8_t> rom,
+Disassembler::DecodeRomFromArrayAsVector(const std::vector<uint8_t> &rom,
                                          bool verbose) {
 
   std::vector<std::string> lines;
+  lines.reserve(rom.size() / 2);
 
+  char line[MAX_LINE_LENGTH];
   for (size_t i = 0; i + 1 < rom.size(); i += 2) {
     uint16_t opcode = (rom[i] << 8u) | rom[i + 1];
-
-    std::ostringstream out;
-
-    if (verbose)
-      out << std::setw(4) << std::setfill('0') << std::hex << i + 0x200 << ": "
-          << std::setw(4) << opcode << "  " << Disassembler::Decode(opcode)
-          << "\n";
-    else
-      out << Disassembler::Decode(opcode) << "\n";
-
-    lines.push_back(out.str());
+    lines.emplace_back(
+        line, Disassembler::DecodeLine(i + 0x200, opcode, verbose, line));
   }
 
   return lines;
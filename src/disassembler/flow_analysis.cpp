@@ -0,0 +1,127 @@
+#include "../../include/disassembler/flow_analysis.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../../include/instruction.hpp"
+
+FlowAnalysis::FlowAnalysis(const uint8_t *rom, size_t size)
+    : size(size), reached(size), referenced(size), called(size),
+      instruction(size), label(size), stop(size) {
+  follow(rom);
+  lay_out();
+}
+
+// ====== Passes ======
+void FlowAnalysis::follow(const uint8_t *rom) {
+  // offset of an address in the ROM, `size` for one outside it
+  auto offset_of = [this](uint16_t addr) -> size_t {
+    return addr >= 0x200 && addr - 0x200u < size ? addr - 0x200u : size;
+  };
+  auto refer = [this, &offset_of](uint16_t addr) {
+    const size_t offset = offset_of(addr);
+    if (offset < size)
+      referenced.Set(offset);
+    return offset;
+  };
+
+  // paths still to follow; each reached instruction adds at most one
+  std::vector<size_t> pending{0};
+  while (!pending.empty()) {
+    size_t pc = pending.back();
+    pending.pop_back();
+
+    // straight-line code up to the end of the path, or code seen before
+    while (pc + 1 < size && !reached.Test(pc)) {
+      const Instruction decoded =
+          DecodeInstruction((rom[pc] << 8u) | rom[pc + 1]);
+      // SYS, undefined opcodes and ch8emu's HALT end a path
+      if (decoded.kind == InstructionKind::SYS ||
+          decoded.kind == InstructionKind::UNKNOWN ||
+          decoded.kind == InstructionKind::HALT) {
+        stop.Set(pc);
+        break;
+      }
+      reached.Set(pc);
+
+      size_t next = pc + 2;
+      switch (decoded.kind) {
+      case InstructionKind::RET:
+        next = size;
+        break;
+      case InstructionKind::JP:
+        pending.push_back(refer(decoded.nnn));
+        next = size;
+        break;
+      case InstructionKind::CALL: {
+        const size_t target = refer(decoded.nnn);
+        if (target < size)
+          called.Set(target);
+        pending.push_back(target);
+        break;
+      }
+      case InstructionKind::LD_I:
+        refer(decoded.nnn);
+        break;
+      case InstructionKind::JP_V0:
+        // the table behind it stays data unless another path reaches it
+        refer(decoded.nnn);
+        indirect_jumps += 1;
+        next = size;
+        break;
+      default:
+        if (IsSkip(decoded.kind))
+          pending.push_back(pc + 4);
+        break;
+      }
+      pc = next;
+    }
+  }
+}
+
+void FlowAnalysis::lay_out() {
+  for (size_t pc = reached.NextSet(0, size); pc < size;
+       pc = reached.NextSet(pc + 2, size)) {
+    instruction.Set(pc);
+    instruction_count += 1;
+  }
+
+  // a target in the second byte of an instruction keeps its address
+  for (size_t offset = referenced.NextSet(0, size); offset < size;
+       offset = referenced.NextSet(offset + 1, size)) {
+    if (offset == 0 || !instruction.Test(offset - 1))
+      label.Set(offset);
+  }
+}
+
+// ====== Bitset ======
+// of a non-zero word
+static size_t count_trailing_zeros(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(bits);
+#else
+  size_t count = 0;
+  for (; (bits & 1u) == 0; bits >>= 1)
+    count += 1;
+  return count;
+#endif
+}
+
+size_t FlowAnalysis::Bitset::NextSet(size_t i, size_t end) const {
+  size_t word = i / 64;
+  if (word >= words.size())
+    return end;
+
+  // whole words of clear bits are skipped
+  uint64_t bits = words[word] & (~uint64_t{0} << (i % 64));
+  while (bits == 0) {
+    word += 1;
+    if (word >= words.size())
+      return end;
+    bits = words[word];
+  }
+
+  const size_t next = word * 64 + count_trailing_zeros(bits);
+  return next < end ? next : end;
+}
@@ -0,0 +1,137 @@
+#include "../../include/disassembler/rom_stats.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../../include/disassembler/flow_analysis.hpp"
+#include "../../include/instruction.hpp"
+
+// ====== Extensions ======
+const char *ExtensionName(Extension extension) {
+  switch (extension) {
+  case Extension::SCHIP:
+    return "schip";
+  case Extension::XO_CHIP:
+    return "xo-chip";
+  case Extension::CH8EMU:
+    return "ch8emu";
+  case Extension::MACHINE_CODE:
+    return "machine-code";
+  default:
+    return "unknown";
+  }
+}
+
+Extension ExtensionOf(uint16_t opcode) {
+  const uint8_t n = opcode & 0x000Fu;
+  const uint8_t kk = opcode & 0x00FFu;
+
+  switch ((opcode & 0xF000u) >> 12u) {
+  case 0x0:
+    if ((opcode & 0xFFF0u) == 0x00C0 || (opcode >= 0x00FB && opcode <= 0x00FF))
+      return Extension::SCHIP;
+    if ((opcode & 0xFFF0u) == 0x00D0)
+      return Extension::XO_CHIP;
+    return Extension::MACHINE_CODE;
+  case 0x5:
+    return n == 0x2 || n == 0x3 ? Extension::XO_CHIP : Extension::UNKNOWN;
+  case 0xF:
+    if (kk == 0x30 || kk == 0x75 || kk == 0x85)
+      return Extension::SCHIP;
+    if (opcode == 0xF000 || opcode == 0xF002 || kk == 0x01 || kk == 0x3A)
+      return Extension::XO_CHIP;
+    if (kk == 0xFF)
+      return Extension::CH8EMU;
+    return Extension::UNKNOWN;
+  default:
+    return Extension::UNKNOWN;
+  }
+}
+
+// ====== Analysis ======
+RomStats AnalyzeRom(const uint8_t *rom, size_t size) {
+  const FlowAnalysis flow(rom, size);
+
+  RomStats stats;
+  stats.size = size;
+  stats.instruction_count = flow.InstructionCount();
+  stats.code_bytes = 2 * flow.InstructionCount();
+
+  // either byte of a reached instruction
+  auto is_code = [&flow, size](uint32_t addr) {
+    if (addr < 0x200 || addr - 0x200 >= size)
+      return false;
+    const size_t offset = addr - 0x200;
+    return flow.IsInstruction(offset) ||
+           (offset > 0 && flow.IsInstruction(offset - 1));
+  };
+
+  // I as the last LD I, addr left it, for as long as nothing else can
+  // have changed it
+  bool i_known = false;
+  uint16_t i = 0;
+
+  size_t next_label = flow.NextLabel(0);
+  for (size_t pc = flow.NextInstruction(0); pc < size;
+       pc = flow.NextInstruction(pc + 2)) {
+    // somewhere else may jump to a label up to here with any I
+    if (next_label <= pc) {
+      i_known = false;
+      next_label = flow.NextLabel(pc + 1);
+    }
+
+    const Instruction decoded =
+        DecodeInstruction((rom[pc] << 8u) | rom[pc + 1]);
+    stats.histogram[static_cast<size_t>(decoded.kind)] += 1;
+
+    switch (decoded.kind) {
+    case InstructionKind::SHR:
+    case InstructionKind::SHL:
+      if (decoded.y != 0 && decoded.y != decoded.x)
+        stats.shifts_reading_vy += 1;
+      break;
+    case InstructionKind::DRW:
+      if (decoded.n == 0)
+        stats.zero_height_draws += 1;
+      break;
+    case InstructionKind::LD_I:
+      i_known = true;
+      i = decoded.nnn;
+      break;
+    case InstructionKind::STORE:
+      if (i_known) {
+        for (uint32_t addr = i; addr <= i + decoded.x; addr += 1) {
+          if (is_code(addr)) {
+            stats.self_modifying.push_back(
+                static_cast<uint16_t>(0x200 + pc));
+            break;
+          }
+        }
+      }
+      // some interpreters advance I past the stored registers
+      i_known = false;
+      break;
+    case InstructionKind::LOAD:
+    case InstructionKind::ADD_I:
+    case InstructionKind::LD_FONT:
+    // the next instruction is reached from somewhere else, or after a
+    // subroutine that may load I itself
+    case InstructionKind::JP:
+    case InstructionKind::CALL:
+    case InstructionKind::RET:
+    case InstructionKind::JP_V0:
+      i_known = false;
+      break;
+    default:
+      break;
+    }
+  }
+
+  for (size_t pc = flow.NextStop(0); pc < size; pc = flow.NextStop(pc + 1)) {
+    const uint16_t opcode = (rom[pc] << 8u) | rom[pc + 1];
+    stats.stops.push_back({static_cast<uint16_t>(0x200 + pc), opcode});
+    stats.extensions[static_cast<size_t>(ExtensionOf(opcode))] += 1;
+  }
+
+  return stats;
+}
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../include/emulator/hot_reload.hpp"
+
+HotReloader::HotReloader(std::string source_path)
+    : watcher(std::move(source_path)) {
+  watcher.Changed();
+  assembler.Update(ReadSource(watcher.Path()));
+
+  loaded = assembler.GetBytes();
+  if (Chip8::STARTING_ADDRESS + loaded.size() > 4096)
+    throw std::runtime_error("rom too big");
+
+  snapshot_labels();
+}
+
+HotReloader::ReloadStats HotReloader::Reload(Chip8 &cpu) {
+  ReloadStats stats;
+
+  assembler.Update(ReadSource(watcher.Path()));
+  const auto &next = assembler.GetBytes();
+  if (Chip8::STARTING_ADDRESS + next.size() > 4096)
+    throw std::runtime_error("rom too big");
+
+  // diffed against the previous build, not memory, so data the program
+  // wrote into its own image survives unless its source line changed
+  const size_t count = std::max(next.size(), loaded.size());
+  bool in_region = false;
+  for (size_t i = 0; i < count; i += 1) {
+    const uint8_t want = i < next.size() ? next[i] : 0;
+    const uint8_t had = i < loaded.size() ? loaded[i] : 0;
+
+    if (want == had) {
+      in_region = false;
+      continue;
+    }
+
+    cpu.memory[Chip8::STARTING_ADDRESS + i] = want;
+    stats.bytes_patched += 1;
+    if (!in_region)
+      stats.regions += 1;
+    in_region = true;
+  }
+
+  // the layout shifted when a label moved
+  const auto &table = assembler.GetLabelTable();
+  for (const auto &[addr, name] : labels) {
+    const auto it = table.find(name);
+    if (it != table.end() && it->second != addr) {
+      stats.remapped = true;
+      break;
+    }
+  }
+
+  if (stats.remapped) {
+    cpu.pc = remap(cpu.pc);
+    cpu.index = remap(cpu.index);
+    for (size_t i = 0; i < cpu.sp && i < 16; i += 1)
+      cpu.stack[i] = remap(cpu.stack[i]);
+  }
+
+  cpu.rom = next;
+  loaded = next;
+  snapshot_labels();
+
+  return stats;
+}
+
+void HotReloader::snapshot_labels() {
+  labels.clear();
+  for (const auto &[name, addr] : assembler.GetLabelTable())
+    labels.emplace_back(addr, std::string(name));
+  std::sort(labels.begin(), labels.end());
+}
+
+uint16_t HotReloader::remap(uint16_t addr) const {
+  // fonts and anything past the old image stay put
+  if (addr < Chip8::STARTING_ADDRESS ||
+      addr >= Chip8::STARTING_ADDRESS + loaded.size())
+    return addr;
+
+  // nearest label at or before addr in the old layout
+  auto it = std::upper_bound(
+      labels.begin(), labels.end(), addr,
+      [](uint16_t a, const auto &label) { return a < label.first; });
+  if (it == labels.begin())
+    return addr; // before the first label, which the start never moves
+
+  --it;
+  const auto &table = assembler.GetLabelTable();
+  const auto moved = table.find(it->second);
+  if (moved == table.end())
+    return addr; // label removed, nothing to anchor on
+
+  return moved->second + (addr - it->first);
+}
@@ -0,0 +1,36 @@
+#include "../include/instruction.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// every kind encodes to an opcode that decodes back to the same kind and
+// fields, so INSTRUCTION_FORMS and ClassifyOpcode cannot drift apart
+static constexpr bool round_trips() {
+  for (size_t kind = 0; kind + 1 < INSTRUCTION_KIND_COUNT; kind += 1) {
+    const uint16_t opcode = EncodeInstruction(
+        static_cast<InstructionKind>(kind), 0xA, 0xB, 0x0FFF);
+    if (DecodeInstruction(opcode).kind != static_cast<InstructionKind>(kind) ||
+        EncodeInstruction(DecodeInstruction(opcode)) != opcode)
+      return false;
+  }
+  return true;
+}
+static_assert(round_trips(), "INSTRUCTION_FORMS disagrees with the decoder");
+
+// Two passes over a block: the first only shifts and masks, so the
+// compiler can vectorize it; the second is the table lookup.
+void DecodeInstructions(const uint8_t *bytes, size_t count, Instruction *out) {
+  constexpr size_t BLOCK = 256;
+  uint16_t opcodes[BLOCK];
+
+  for (size_t start = 0; start < count; start += BLOCK) {
+    const size_t block = count - start < BLOCK ? count - start : BLOCK;
+    const uint8_t *in = bytes + 2 * start;
+
+    for (size_t i = 0; i < block; i += 1)
+      opcodes[i] = static_cast<uint16_t>((in[2 * i] << 8u) | in[2 * i + 1]);
+
+    for (size_t i = 0; i < block; i += 1)
+      out[start + i] = DecodeInstruction(opcodes[i]);
+  }
+}
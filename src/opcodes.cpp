@@ -17,9 +17,37 @@ void Chip8::OP_NULL() {
   throw std::runtime_error(msg.str());
 }
 
+// Opcodes outside the instruction set that the nibble-keyed decode tables
+// used to run anyway: 5xyN and 9xyN as SE and SNE, ExnE and Exn1 as SKP and
+// SKNP. Kept so ROMs relying on them behave as before.
+void Chip8::OP_LOOSE() {
+  switch ((opcode & 0xF000u) >> 12u) {
+  case 0x5:
+    OP_5xy0();
+    break;
+  case 0x9:
+    OP_9xy0();
+    break;
+  case 0xE:
+    if (instruction.n == 0xE)
+      OP_Ex9E();
+    else if (instruction.n == 0x1)
+      OP_ExA1();
+    else
+      OP_NULL();
+    break;
+  default:
+    OP_NULL();
+    break;
+  }
+}
+
 // HALT (Stops execution)
 void Chip8::OP_FxFF() { halted = true; }
 
+// SYS (Machine code routine, ignored like most interpreters do)
+void Chip8::OP_0nnn() {}
+
 // CLS (Clears screen)
 void Chip8::OP_00E0() { memset(video, 0, sizeof(video)); }
 
@@ -31,13 +59,13 @@ void Chip8::OP_00EE() {
 
 // JMP nnn
 void Chip8::OP_1nnn() {
-  uint16_t nnn = opcode & 0x0FFFu;
+  uint16_t nnn = instruction.nnn;
   pc = nnn;
 }
 
 // CALL nnn
 void Chip8::OP_2nnn() {
-  uint16_t nnn = opcode & 0x0FFFu;
+  uint16_t nnn = instruction.nnn;
   stack[sp] = pc;
   sp += 1;
   pc = nnn;
@@ -45,8 +73,8 @@ void Chip8::OP_2nnn() {
 
 // SE Vx, kk (Skip next instruction if Vx == kk)
 void Chip8::OP_3xkk() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t kk = (opcode & 0x00FFu);
+  uint8_t x = instruction.x;
+  uint8_t kk = instruction.kk;
 
   if (V[x] == kk) {
     pc += 2;
@@ -55,8 +83,8 @@ void Chip8::OP_3xkk() {
 
 // SNE Vx, kk (Skip next instruction if Vx != kk)
 void Chip8::OP_4xkk() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t kk = (opcode & 0x00FFu);
+  uint8_t x = instruction.x;
+  uint8_t kk = instruction.kk;
 
   if (V[x] != kk) {
     pc += 2;
@@ -66,8 +94,8 @@ void Chip8::OP_4xkk() {
 // SE Vx, Vy (Skip next instruction if Vx = Vy)
 void Chip8::OP_5xy0() {
 
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
 
   if (V[x] == V[y]) {
     pc += 2;
@@ -76,16 +104,16 @@ void Chip8::OP_5xy0() {
 
 // LD Vx, kk (Set Vx = kk)
 void Chip8::OP_6xkk() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t kk = (opcode & 0x00FFu);
+  uint8_t x = instruction.x;
+  uint8_t kk = instruction.kk;
 
   V[x] = kk;
 }
 
 // ADD Vx, kk (Set Vx = Vx + kk)
 void Chip8::OP_7xkk() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t kk = (opcode & 0x00FFu);
+  uint8_t x = instruction.x;
+  uint8_t kk = instruction.kk;
 
   V[x] = V[x] + kk;
 }
@@ -93,8 +121,8 @@ void Chip8::OP_7xkk() {
 // SNE Vx, Vy (Skip next instruction if Vx != Vy)
 void Chip8::OP_9xy0() {
 
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
 
   if (V[x] != V[y]) {
     pc += 2;
@@ -103,29 +131,29 @@ void Chip8::OP_9xy0() {
 
 // LD I, nnn
 void Chip8::OP_Annn() {
-  uint16_t nnn = opcode & 0x0FFFu;
+  uint16_t nnn = instruction.nnn;
   index = nnn;
 }
 
 // JMP V0, nnn (Jump to location nnn + V0)
 void Chip8::OP_Bnnn() {
-  uint16_t nnn = opcode & 0x0FFFu;
+  uint16_t nnn = instruction.nnn;
   pc = nnn + V[0];
 }
 
 // RND Vx, byte (Set Vx = random byte & kk)
 void Chip8::OP_Cxkk() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t kk = (opcode & 0x00FFu);
+  uint8_t x = instruction.x;
+  uint8_t kk = instruction.kk;
 
-  V[x] = (rand() % 256) & kk;
+  V[x] = NextRandomByte() & kk;
 }
 
 // DRW Vx, Vy, nibble
 void Chip8::OP_Dxyn() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
-  uint8_t n = (opcode & 0x000Fu);
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
+  uint8_t n = instruction.n;
 
   uint8_t x_pos = V[x] % VIDEO_WIDTH;
   uint8_t y_pos = V[y] % VIDEO_HEIGHT;
@@ -158,40 +186,40 @@ void Chip8::OP_Dxyn() {
 
 // LD Vx, Vy (Set Vx = Vy)
 void Chip8::OP_8xy0() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
 
   V[x] = V[y];
 }
 
 // OR Vx, Vy
 void Chip8::OP_8xy1() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
 
   V[x] |= V[y];
 }
 
 // AND Vx, Vy
 void Chip8::OP_8xy2() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
 
   V[x] &= V[y];
 }
 
 // XOR Vx, Vy
 void Chip8::OP_8xy3() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
 
   V[x] ^= V[y];
 }
 
 // ADD Vx, Vy (set Vx = Vx + Vy, set Vf = 1 if carry else 0)
 void Chip8::OP_8xy4() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
 
   uint16_t sum = V[x] + V[y];
 
@@ -201,8 +229,8 @@ void Chip8::OP_8xy4() {
 
 // SUB Vx, Vy (set Vx = Vx - Vy, set Vf = 1 if not borrow else 0)
 void Chip8::OP_8xy5() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
 
   V[0xF] = V[x] > V[y] ? 1 : 0;
 
@@ -211,7 +239,7 @@ void Chip8::OP_8xy5() {
 
 // SHR Vx (Right shift Vx by 1, and set Vf = 1 if LSB of Vx is 1 else 0)
 void Chip8::OP_8xy6() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
 
   V[0xF] = V[x] & 0x1;
   V[x] >>= 1;
@@ -219,8 +247,8 @@ void Chip8::OP_8xy6() {
 
 // SUBN Vx, Vy (Set Vx = Vy - Vx, and set Vf = 1 if Vy > Vx, else 0)
 void Chip8::OP_8xy7() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
-  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t x = instruction.x;
+  uint8_t y = instruction.y;
 
   V[0xF] = V[y] > V[x] ? 1 : 0;
   V[x] = V[y] - V[x];
@@ -228,7 +256,7 @@ void Chip8::OP_8xy7() {
 
 // SHL Vx (Left shift Vx by 1, and set Vf = 1 if MSB of Vx is 1 else 0)
 void Chip8::OP_8xyE() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
 
   V[0xF] = (V[x] & 0x80) >> 7u;
   V[x] <<= 1;
@@ -236,7 +264,7 @@ void Chip8::OP_8xyE() {
 
 // SKP Vx (Skip next instruction if key with the value of Vx is pressed)
 void Chip8::OP_Ex9E() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
 
   if (keypad[V[x]]) {
     pc += 2;
@@ -245,7 +273,7 @@ void Chip8::OP_Ex9E() {
 
 // SKPN Vx (Skip next instruction if key with the value of Vx is not pressed)
 void Chip8::OP_ExA1() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
 
   if (!keypad[V[x]]) {
     pc += 2;
@@ -254,14 +282,14 @@ void Chip8::OP_ExA1() {
 
 // LD Vx, DT
 void Chip8::OP_Fx07() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
 
   V[x] = delay;
 }
 
 // LD Vx, K (Wait for keypress, store the value of the key in Vx)
 void Chip8::OP_Fx0A() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
   // Wait for a key press, store the value of the key in Vx
 
   for (uint8_t i = 0; i < 16; i += 1) {
@@ -276,21 +304,21 @@ void Chip8::OP_Fx0A() {
 
 // LD DT, Vx
 void Chip8::OP_Fx15() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
   // Set delay timer = Vx
   delay = V[x];
 }
 
 // LD ST, Vx
 void Chip8::OP_Fx18() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
   // Set sound timer = Vx
-  sound = V[x];
+  SetSoundTimer(V[x]);
 }
 
 // ADD I, Vx
 void Chip8::OP_Fx1E() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
   // Set I = I + Vx
 
   // overflow flag
@@ -300,14 +328,14 @@ void Chip8::OP_Fx1E() {
 
 // LD F, Vx
 void Chip8::OP_Fx29() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
   // Set I = location of sprite for digit Vx
   index = FONTSET_START_ADDRESS + (5 * V[x]);
 }
 
 // LD B, Vx
 void Chip8::OP_Fx33() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
   // Store BCD representation of Vx in memory locations I, I+1, and I+2
 
   uint8_t val = V[x];
@@ -326,7 +354,7 @@ void Chip8::OP_Fx33() {
 
 // LD [I], Vx
 void Chip8::OP_Fx55() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
   // Store registers V0 through Vx in memory starting at location I.
   for (uint8_t i = 0; i <= x; i += 1) {
     memory[index + i] = V[i];
@@ -335,7 +363,7 @@ void Chip8::OP_Fx55() {
 
 // LD Vx, [I]
 void Chip8::OP_Fx65() {
-  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t x = instruction.x;
   // Read registers V0 through Vx from memory starting at location I
   for (uint8_t i = 0; i <= x; i += 1) {
     V[i] = memory[index + i];
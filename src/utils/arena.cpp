@@ -0,0 +1,34 @@
+#include "../../include/utils/arena.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+Arena::Arena(size_t block_size) : block_size(block_size) {}
+
+void *Arena::Allocate(size_t size, size_t alignment) {
+  if (size == 0)
+    size = 1;
+
+  size_t padding =
+      (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+
+  if (cursor == nullptr || padding + size > remaining) {
+    // oversized requests get a block of their own
+    const size_t new_block_size = std::max(block_size, size + alignment);
+    blocks.emplace_back(new uint8_t[new_block_size]);
+
+    cursor = blocks.back().get();
+    remaining = new_block_size;
+    padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) %
+              alignment;
+  }
+
+  uint8_t *ptr = cursor + padding;
+  cursor += padding + size;
+  remaining -= padding + size;
+  used += size;
+
+  return ptr;
+}
@@ -0,0 +1,220 @@
+#include "../../include/utils/artifact_cache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+uint64_t ArtifactCache::Key(std::initializer_list<std::string_view> parts) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  auto mix = [&hash](uint8_t byte) {
+    hash ^= byte;
+    hash *= 0x100000001b3ull;
+  };
+
+  for (std::string_view part : parts) {
+    for (int i = 0; i < 8; i += 1)
+      mix(static_cast<uint64_t>(part.size()) >> (8 * i));
+    for (char c : part)
+      mix(static_cast<uint8_t>(c));
+  }
+  return hash;
+}
+
+ArtifactCache::ArtifactCache(std::string dir, uint64_t max_bytes)
+    : dir(std::move(dir)), max_bytes(max_bytes) {}
+
+std::string ArtifactCache::entry_path(uint64_t key,
+                                      std::string_view extension) const {
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(key));
+  return (fs::path(dir) / (name + std::string(extension))).string();
+}
+
+void ArtifactCache::touch(const std::string &path) {
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
+
+// ====== Lookups ======
+std::optional<MappedFile> ArtifactCache::Map(uint64_t key,
+                                             std::string_view extension) {
+  const std::string path = entry_path(key, extension);
+  try {
+    MappedFile file(path);
+    touch(path);
+    return file;
+  } catch (const std::exception &) {
+    return std::nullopt;
+  }
+}
+
+// shares the source blocks, false where the file system cannot
+static bool reflink(const std::string &from, const std::string &to) {
+#if defined(__linux__) && defined(FICLONE)
+  const int src = open(from.c_str(), O_RDONLY);
+  if (src < 0)
+    return false;
+  const int dst = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (dst < 0) {
+    close(src);
+    return false;
+  }
+
+  const bool cloned = ioctl(dst, FICLONE, src) == 0;
+  close(dst);
+  close(src);
+  return cloned;
+#else
+  (void)from;
+  (void)to;
+  return false;
+#endif
+}
+
+bool ArtifactCache::CopyTo(uint64_t key, std::string_view extension,
+                           const std::string &path) {
+  const std::string entry = entry_path(key, extension);
+
+  std::error_code ec;
+  if (!fs::is_regular_file(entry, ec))
+    return false;
+
+  if (!reflink(entry, path)) {
+    // the entry may have been evicted since
+    fs::copy_file(entry, path, fs::copy_options::overwrite_existing, ec);
+    if (ec)
+      return false;
+  }
+
+  touch(entry);
+  return true;
+}
+
+// ====== Writes ======
+void ArtifactCache::Store(uint64_t key, std::string_view extension,
+                          const void *data, size_t size) {
+  const std::string path = entry_path(key, extension);
+
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+
+  // unique per thread and call, racing writers each rename a whole file
+  std::ostringstream tmp_name;
+  tmp_name << path << ".tmp"
+           << std::hash<std::thread::id>{}(std::this_thread::get_id()) << "."
+           << std::chrono::steady_clock::now().time_since_epoch().count();
+  const std::string tmp_path = tmp_name.str();
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    file.write(static_cast<const char *>(data), size);
+    if (!file) {
+      file.close();
+      fs::remove(tmp_path, ec);
+      return;
+    }
+  }
+  fs::rename(tmp_path, path, ec);
+  if (ec) {
+    fs::remove(tmp_path, ec);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (scanned)
+    total_bytes += size;
+  if (!scanned || total_bytes > max_bytes)
+    evict();
+}
+
+// the extensions ch8asm and ch8dis store under
+static constexpr std::string_view ENTRY_EXTENSIONS[] = {".ch8", ".deps",
+                                                        ".ch8mod", ".dis"};
+
+// "<16 hex digits><extension>", as entry_path names them. anything else in
+// the directory is not ours to count or delete; temporary files, which
+// belong to writers still running, do not match either
+static bool is_entry_name(std::string_view name) {
+  if (name.size() < 16 ||
+      !std::all_of(name.begin(), name.begin() + 16, [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+      }))
+    return false;
+
+  name.remove_prefix(16);
+  return std::find(std::begin(ENTRY_EXTENSIONS), std::end(ENTRY_EXTENSIONS),
+                   name) != std::end(ENTRY_EXTENSIONS);
+}
+
+// under `mutex`: counts the entries in the directory, and drops the least
+// recently used ones until they are back to 3/4 of the bound
+void ArtifactCache::evict() {
+  struct Entry {
+    fs::file_time_type last_use;
+    uint64_t size;
+    fs::path path;
+  };
+
+  std::vector<Entry> entries;
+  total_bytes = 0;
+
+  std::error_code ec;
+  for (fs::directory_iterator it(dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    if (!is_entry_name(it->path().filename().string()))
+      continue;
+
+    std::error_code entry_ec;
+    if (!it->is_regular_file(entry_ec))
+      continue;
+    const uint64_t size = it->file_size(entry_ec);
+    const auto last_use = it->last_write_time(entry_ec);
+    if (entry_ec)
+      continue;
+
+    entries.push_back({last_use, size, it->path()});
+    total_bytes += size;
+  }
+  scanned = true;
+
+  if (total_bytes <= max_bytes)
+    return;
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) {
+              return a.last_use < b.last_use;
+            });
+
+  const uint64_t target = max_bytes / 4 * 3;
+  for (const auto &entry : entries) {
+    if (total_bytes <= target)
+      break;
+    if (fs::remove(entry.path, ec))
+      total_bytes -= entry.size;
+  }
+}
@@ -0,0 +1,198 @@
+#include "../../include/utils/batch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../../include/utils/thread_pool.hpp"
+
+namespace fs = std::filesystem;
+
+// ====== Inputs ======
+// '*' matches any run of characters, '?' any one
+static bool glob_match(std::string_view pattern, std::string_view name) {
+  size_t p = 0, n = 0;
+  size_t star = std::string_view::npos, resume = 0;
+
+  while (n < name.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+      p += 1;
+      n += 1;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      resume = n;
+    } else if (star != std::string_view::npos) {
+      p = star + 1;
+      n = ++resume;
+    } else {
+      return false;
+    }
+  }
+
+  while (p < pattern.size() && pattern[p] == '*')
+    p += 1;
+  return p == pattern.size();
+}
+
+static void expand(const std::string &arg, std::vector<std::string> &out) {
+  const fs::path path(arg);
+  const std::string pattern = path.filename().string();
+  if (pattern.find_first_of("*?") == std::string::npos) {
+    out.push_back(arg);
+    return;
+  }
+
+  const fs::path dir = path.has_parent_path() ? path.parent_path() : ".";
+  std::vector<std::string> matches;
+  for (const auto &entry : fs::directory_iterator(dir)) {
+    if (entry.is_regular_file() &&
+        glob_match(pattern, entry.path().filename().string()))
+      matches.push_back(path.has_parent_path()
+                            ? entry.path().string()
+                            : entry.path().filename().string());
+  }
+
+  std::sort(matches.begin(), matches.end());
+  out.insert(out.end(), matches.begin(), matches.end());
+}
+
+// the same string for every path to one file, the path itself where it
+// cannot be resolved
+static std::string identity(const std::string &path) {
+  std::error_code ec;
+  const fs::path resolved = fs::weakly_canonical(path, ec);
+  return ec ? fs::path(path).lexically_normal().string() : resolved.string();
+}
+
+void RemoveDuplicateInputs(std::vector<std::string> &paths) {
+  std::unordered_set<std::string> seen;
+  paths.erase(std::remove_if(paths.begin(), paths.end(),
+                             [&seen](const std::string &path) {
+                               return !seen.insert(identity(path)).second;
+                             }),
+              paths.end());
+}
+
+std::vector<std::string> ExpandInputs(const std::vector<std::string> &args) {
+  std::vector<std::string> inputs;
+
+  for (const auto &arg : args) {
+    if (arg != "-") {
+      expand(arg, inputs);
+      continue;
+    }
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+      const size_t first = line.find_first_not_of(" \t\r");
+      if (first == std::string::npos)
+        continue;
+      const size_t last = line.find_last_not_of(" \t\r");
+      expand(line.substr(first, last - first + 1), inputs);
+    }
+  }
+
+  RemoveDuplicateInputs(inputs);
+  return inputs;
+}
+
+std::string BatchOutputPath(const std::string &input,
+                            const std::string &out_dir,
+                            const std::string &extension) {
+  fs::path path(input);
+  path.replace_extension(extension);
+  if (!out_dir.empty())
+    path = fs::path(out_dir) / path.filename();
+  return path.string();
+}
+
+std::vector<std::string>
+BatchOutputPaths(const std::vector<std::string> &inputs,
+                 const std::string &out_dir, const std::string &extension) {
+  std::vector<std::string> outputs;
+  std::unordered_map<std::string, size_t> writer;
+  for (size_t i = 0; i < inputs.size(); i += 1) {
+    outputs.push_back(BatchOutputPath(inputs[i], out_dir, extension));
+
+    const auto [it, inserted] = writer.emplace(identity(outputs[i]), i);
+    if (!inserted) {
+      throw std::runtime_error(inputs[it->second] + " and " + inputs[i] +
+                               " would both write " + outputs[i]);
+    }
+  }
+  return outputs;
+}
+
+// ====== Running ======
+BatchReport
+RunBatch(const std::vector<std::string> &inputs, size_t threads,
+         const std::function<BatchJobResult(const std::string &)> &job) {
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<BatchJobResult> results(inputs.size());
+  std::vector<std::string> errors(inputs.size());
+  std::vector<char> failed(inputs.size(), 0);
+
+  // jobs never throw into the pool, one bad file must not stop the rest
+  ThreadPool pool(threads);
+  pool.ParallelFor(inputs.size(), [&](size_t i) {
+    try {
+      results[i] = job(inputs[i]);
+    } catch (const std::exception &e) {
+      errors[i] = e.what();
+      failed[i] = 1;
+    }
+  });
+
+  BatchReport report;
+  report.files = inputs.size();
+  for (size_t i = 0; i < inputs.size(); i += 1) {
+    if (failed[i]) {
+      std::cerr << inputs[i] << ": " << errors[i] << "\n";
+      report.failed += 1;
+      continue;
+    }
+    report.bytes_in += results[i].bytes_in;
+    report.bytes_out += results[i].bytes_out;
+  }
+
+  report.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return report;
+}
+
+void PrintBatchReport(std::ostream &out, const BatchReport &report) {
+  const double mb_per_second =
+      report.seconds > 0 ? report.bytes_in / report.seconds / 1e6 : 0;
+
+  out << report.files << " files (" << report.failed << " failed), "
+      << report.bytes_in << " bytes in, " << report.bytes_out
+      << " bytes out in " << static_cast<uint64_t>(report.seconds * 1000)
+      << " ms, " << mb_per_second << " MB/s\n";
+}
+
+void WriteWholeFile(const std::string &path, const void *data, size_t size) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open file for writing: " + path);
+  }
+
+  file.write(static_cast<const char *>(data), size);
+  if (!file) {
+    throw std::runtime_error("failed to write data to file: " + path);
+  }
+}
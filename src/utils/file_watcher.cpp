@@ -0,0 +1,123 @@
+#include "../../include/utils/file_watcher.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define CHIP8_HAVE_INOTIFY 1
+#endif
+
+FileWatcher::FileWatcher(std::string path) : path(std::move(path)) {
+#ifdef CHIP8_HAVE_INOTIFY
+  const std::filesystem::path file(this->path);
+  const std::string dir =
+      file.has_parent_path() ? file.parent_path().string() : ".";
+  name = file.filename().string();
+
+  // written in place, or renamed over
+  const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+  inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd >= 0 && inotify_add_watch(inotify_fd, dir.c_str(), mask) < 0) {
+    close(inotify_fd);
+    inotify_fd = -1;
+  }
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef CHIP8_HAVE_INOTIFY
+  if (inotify_fd >= 0)
+    close(inotify_fd);
+#endif
+}
+
+bool FileWatcher::Changed() {
+  namespace fs = std::filesystem;
+
+  if (inotify_fd >= 0) {
+    read_events();
+    if (!pending)
+      return false;
+  } else {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_poll < POLL_INTERVAL)
+      return false;
+    last_poll = now;
+  }
+
+  // editors that save by renaming leave a short window without the file
+  std::error_code ec;
+  const auto write_time = fs::last_write_time(path, ec);
+  if (ec)
+    return false;
+  const auto size = fs::file_size(path, ec);
+  if (ec)
+    return false;
+  pending = false;
+
+  if (seen && write_time == last_write && size == last_size)
+    return false;
+
+  seen = true;
+  last_write = write_time;
+  last_size = size;
+  return true;
+}
+
+void FileWatcher::Wait() {
+#ifdef CHIP8_HAVE_INOTIFY
+  if (inotify_fd >= 0) {
+    // a missed check is retried after an interval rather than on the next
+    // event, which may never come
+    pollfd events{inotify_fd, POLLIN, 0};
+    const auto timeout =
+        pending ? static_cast<int>(POLL_INTERVAL.count()) : -1;
+    poll(&events, 1, timeout);
+    return;
+  }
+#endif
+  std::this_thread::sleep_for(POLL_INTERVAL);
+}
+
+void FileWatcher::read_events() {
+#ifdef CHIP8_HAVE_INOTIFY
+  alignas(inotify_event) char buffer[4096];
+  while (true) {
+    const ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+    if (length <= 0)
+      return;
+
+    for (ssize_t offset = 0; offset < length;) {
+      const auto *event =
+          reinterpret_cast<const inotify_event *>(buffer + offset);
+      // the queue overflowed, anything may have happened
+      if ((event->mask & IN_Q_OVERFLOW) ||
+          (event->len > 0 && name == event->name))
+        pending = true;
+      offset += sizeof(inotify_event) + event->len;
+    }
+  }
+#endif
+}
+
+std::string ReadSource(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open source file: " + path);
+  }
+
+  std::ostringstream oss;
+  oss << file.rdbuf();
+  return oss.str();
+}
@@ -0,0 +1,87 @@
+#include "../../include/utils/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CHIP8_HAVE_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::string &path) {
+#ifdef CHIP8_HAVE_MMAP
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("failed to open file: " + path);
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("failed to open file: " + path);
+  }
+
+  // mmap rejects empty mappings
+  if (st.st_size > 0) {
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("failed to map file: " + path);
+    }
+    bytes = static_cast<const uint8_t *>(addr);
+    length = st.st_size;
+    mapped = true;
+  }
+  close(fd);
+#else
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("failed to open file: " + path);
+
+  buffer.assign(std::istreambuf_iterator<char>(file), {});
+  bytes = buffer.empty() ? nullptr : buffer.data();
+  length = buffer.size();
+#endif
+}
+
+MappedFile::~MappedFile() { release(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : bytes(other.bytes), length(other.length), mapped(other.mapped),
+      buffer(std::move(other.buffer)) {
+  other.bytes = nullptr;
+  other.length = 0;
+  other.mapped = false;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    release();
+    bytes = other.bytes;
+    length = other.length;
+    mapped = other.mapped;
+    buffer = std::move(other.buffer);
+    other.bytes = nullptr;
+    other.length = 0;
+    other.mapped = false;
+  }
+  return *this;
+}
+
+void MappedFile::release() {
+#ifdef CHIP8_HAVE_MMAP
+  if (mapped)
+    munmap(const_cast<uint8_t *>(bytes), length);
+#endif
+  bytes = nullptr;
+  length = 0;
+  mapped = false;
+}
@@ -0,0 +1,21 @@
+#include "../../include/utils/parse_count.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+
+bool ParseCount(std::string_view text, uint64_t max, uint64_t &count) {
+  // from_chars skips no whitespace but does take a leading '-'
+  if (text.empty() || text[0] < '0' || text[0] > '9')
+    return false;
+
+  uint64_t value = 0;
+  const char *end = text.data() + text.size();
+  const auto [last, error] = std::from_chars(text.data(), end, value);
+  if (error != std::errc() || last != end || value > max)
+    return false;
+
+  count = value;
+  return true;
+}
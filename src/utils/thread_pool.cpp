@@ -0,0 +1,127 @@
+#include "../../include/utils/thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+ThreadPool::ThreadPool(size_t thread_count) {
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+  // the calling thread is one of the workers. a failed spawn leaves no
+  // destructor to run, so the workers already started are joined here
+  try {
+    for (size_t i = 1; i < thread_count; i += 1) {
+      workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+  } catch (...) {
+    stop();
+    throw;
+  }
+}
+
+ThreadPool::~ThreadPool() { stop(); }
+
+void ThreadPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  work_ready.notify_all();
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::run_job(const std::function<void(size_t)> &fn,
+                         size_t count) {
+  for (size_t i = next_index.fetch_add(1); i < count;
+       i = next_index.fetch_add(1)) {
+    try {
+      fn(i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+}
+
+void ThreadPool::worker_loop() {
+  size_t seen_generation = 0;
+
+  while (true) {
+    const std::function<void(size_t)> *fn = nullptr;
+    size_t count = 0;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      work_ready.wait(lock, [&] {
+        return stopping || generation != seen_generation;
+      });
+
+      if (stopping)
+        return;
+
+      seen_generation = generation;
+
+      // woke up after the job was already finished by the others
+      if (job == nullptr)
+        continue;
+
+      fn = job;
+      count = job_count;
+      busy_workers += 1;
+    }
+
+    run_job(*fn, count);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      busy_workers -= 1;
+    }
+    work_done.notify_all();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t count,
+                             const std::function<void(size_t)> &fn) {
+  if (count == 0)
+    return;
+
+  if (workers.empty() || count == 1) {
+    for (size_t i = 0; i < count; i += 1) {
+      fn(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = &fn;
+    job_count = count;
+    next_index.store(0);
+    error = nullptr;
+    generation += 1;
+  }
+  work_ready.notify_all();
+
+  run_job(fn, count);
+
+  // every index is taken, wait for the workers still finishing theirs
+  std::exception_ptr job_error;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [&] { return busy_workers == 0; });
+    job = nullptr;
+    job_error = error;
+    error = nullptr;
+  }
+
+  if (job_error)
+    std::rethrow_exception(job_error);
+}
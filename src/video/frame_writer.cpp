@@ -0,0 +1,129 @@
+#include "../../include/video/frame_writer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+FrameFormat ParseFrameFormat(const std::string &format) {
+  std::string lower = format;
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+
+  if (lower == "raw")
+    return FrameFormat::Raw;
+  if (lower == "ppm")
+    return FrameFormat::PPM;
+  if (lower == "y4m")
+    return FrameFormat::Y4M;
+
+  throw std::invalid_argument("invalid format. must be 'raw', 'ppm' or 'y4m'");
+}
+
+FrameWriter::FrameWriter(std::ostream &out, FrameFormat format, size_t width,
+                         size_t height, unsigned int fps, size_t scale)
+    : out(out), format(format), width(width), height(height), fps(fps),
+      scale(scale) {
+
+  if (scale == 0) {
+    throw std::invalid_argument("scale must be at least 1");
+  }
+
+  // a PPM frame, 3 bytes per scaled pixel, is the largest of the buffers
+  const size_t limit = SIZE_MAX / 3;
+  const bool overflows =
+      (width != 0 && scale > limit / width) ||
+      (height != 0 && scale > limit / height) ||
+      (height != 0 && width * scale > limit / (height * scale));
+  if (overflows) {
+    throw std::invalid_argument("scale is too large for the frame size");
+  }
+
+  const size_t w = width * scale;
+  const size_t h = height * scale;
+
+  switch (format) {
+  case FrameFormat::Raw:
+    buffer.resize((width * height + 7) / 8);
+    break;
+  case FrameFormat::PPM:
+    buffer.resize(w * h * 3);
+    break;
+  case FrameFormat::Y4M:
+    // luma plane followed by two quarter-size chroma planes
+    buffer.resize(w * h + 2 * ((w + 1) / 2) * ((h + 1) / 2));
+    break;
+  }
+}
+
+void FrameWriter::write_header() {
+  if (format != FrameFormat::Y4M)
+    return;
+
+  out << "YUV4MPEG2 W" << width * scale << " H" << height * scale << " F"
+      << fps << ":1 Ip A1:1 C420jpeg\n";
+}
+
+void FrameWriter::pack_bits(const uint8_t *video) {
+  std::fill(buffer.begin(), buffer.end(), 0);
+
+  for (size_t i = 0; i < width * height; i += 1) {
+    if (video[i])
+      buffer[i / 8] |= 0x80u >> (i % 8);
+  }
+}
+
+void FrameWriter::scale_luma(const uint8_t *video, uint8_t *dst,
+                             size_t channels) {
+  const size_t row_bytes = width * scale * channels;
+
+  for (size_t y = 0; y < height; y += 1) {
+    uint8_t *row = dst + y * scale * row_bytes;
+
+    for (size_t x = 0; x < width; x += 1) {
+      const uint8_t value = video[y * width + x] ? 255 : 0;
+      std::memset(row + x * scale * channels, value, scale * channels);
+    }
+
+    // duplicate the row for vertical scaling
+    for (size_t s = 1; s < scale; s += 1) {
+      std::memcpy(row + s * row_bytes, row, row_bytes);
+    }
+  }
+}
+
+void FrameWriter::WriteFrame(const uint8_t *video) {
+  if (frames_written == 0)
+    write_header();
+
+  const size_t w = width * scale;
+  const size_t h = height * scale;
+
+  switch (format) {
+  case FrameFormat::Raw:
+    pack_bits(video);
+    break;
+
+  case FrameFormat::PPM:
+    out << "P6\n" << w << " " << h << "\n255\n";
+    scale_luma(video, buffer.data(), 3);
+    break;
+
+  case FrameFormat::Y4M:
+    out << "FRAME\n";
+    scale_luma(video, buffer.data(), 1);
+    std::fill(buffer.begin() + w * h, buffer.end(), 128);
+    break;
+  }
+
+  out.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+  if (!out) {
+    throw std::runtime_error("failed to write frame");
+  }
+
+  frames_written += 1;
+}
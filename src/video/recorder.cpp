@@ -0,0 +1,210 @@
+#include "../../include/video/recorder.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../../include/video/frame_writer.hpp"
+
+Recorder::Recorder(size_t width, size_t height, size_t capacity)
+    : width(width), height(height), packed_size((width * height + 7) / 8),
+      slots(capacity), base_frame(packed_size, 0), last_frame(packed_size, 0),
+      scratch(packed_size, 0) {
+
+  if (capacity == 0) {
+    throw std::invalid_argument("recorder capacity must be at least 1");
+  }
+
+  // worst case RLE output, so capture never reallocates: bytes alternating
+  // changed and unchanged cost 3 output bytes for every 2
+  for (auto &slot : slots) {
+    slot.delta.reserve(packed_size + packed_size / 2 + 2);
+  }
+}
+
+// ====== Packing ======
+void Recorder::pack(const uint8_t *video, uint8_t *dst) const {
+  const size_t pixels = width * height;
+
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    dst[i / 8] = (video[i] << 7) | (video[i + 1] << 6) | (video[i + 2] << 5) |
+                 (video[i + 3] << 4) | (video[i + 4] << 3) |
+                 (video[i + 5] << 2) | (video[i + 6] << 1) | video[i + 7];
+  }
+
+  if (i < pixels) {
+    dst[i / 8] = 0;
+    for (; i < pixels; i += 1) {
+      if (video[i])
+        dst[i / 8] |= 0x80u >> (i % 8);
+    }
+  }
+}
+
+void Recorder::unpack(const uint8_t *src, uint8_t *video) const {
+  for (size_t i = 0; i < width * height; i += 1) {
+    video[i] = (src[i / 8] >> (7 - i % 8)) & 1u;
+  }
+}
+
+// ====== RLE ======
+// stream of [zero run][literal count][literals...], counts capped at 255
+void Recorder::encode(const uint8_t *current, const uint8_t *previous,
+                      size_t size, std::vector<uint8_t> &out) {
+  out.clear();
+
+  size_t i = 0;
+  while (i < size) {
+    uint8_t zeros = 0;
+    while (i < size && zeros < 255 && (current[i] ^ previous[i]) == 0) {
+      zeros += 1;
+      i += 1;
+    }
+
+    const size_t literal_start = i;
+    uint8_t literals = 0;
+    while (i < size && literals < 255 && (current[i] ^ previous[i]) != 0) {
+      literals += 1;
+      i += 1;
+    }
+
+    out.push_back(zeros);
+    out.push_back(literals);
+    for (size_t j = literal_start; j < i; j += 1) {
+      out.push_back(current[j] ^ previous[j]);
+    }
+  }
+}
+
+void Recorder::apply(const std::vector<uint8_t> &delta, uint8_t *frame) {
+  size_t pos = 0;
+  size_t i = 0;
+
+  while (i + 1 < delta.size()) {
+    pos += delta[i];
+    const uint8_t literals = delta[i + 1];
+    i += 2;
+
+    for (uint8_t j = 0; j < literals; j += 1) {
+      frame[pos] ^= delta[i];
+      pos += 1;
+      i += 1;
+    }
+  }
+}
+
+// ====== Capture ======
+void Recorder::Capture(const uint8_t *video, const AudioEvent *events,
+                       size_t event_count) {
+  Slot &slot = slots[head];
+
+  // ring is full, fold the oldest frame into the base before overwriting it
+  if (count == slots.size()) {
+    apply(slot.delta, base_frame.data());
+    if (!slot.events.empty())
+      base_sound = slot.events.back().on;
+  } else {
+    count += 1;
+  }
+
+  pack(video, scratch.data());
+  encode(scratch.data(), last_frame.data(), packed_size, slot.delta);
+  std::swap(scratch, last_frame);
+
+  slot.events.assign(events, events + event_count);
+
+  head = (head + 1) % slots.size();
+}
+
+// ====== Dump ======
+static void write_u32(std::ofstream &out, uint32_t v) {
+  const uint8_t b[4] = {uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16),
+                        uint8_t(v >> 24)};
+  out.write(reinterpret_cast<const char *>(b), 4);
+}
+
+static void write_u16(std::ofstream &out, uint16_t v) {
+  const uint8_t b[2] = {uint8_t(v), uint8_t(v >> 8)};
+  out.write(reinterpret_cast<const char *>(b), 2);
+}
+
+size_t Recorder::Dump(const std::string &basename, size_t scale) const {
+  std::ofstream video_file(basename + ".y4m", std::ios::binary);
+  if (!video_file.is_open()) {
+    throw std::runtime_error("failed to open file for writing: " + basename +
+                             ".y4m");
+  }
+
+  std::ofstream audio_file(basename + ".wav", std::ios::binary);
+  if (!audio_file.is_open()) {
+    throw std::runtime_error("failed to open file for writing: " + basename +
+                             ".wav");
+  }
+
+  // ====== WAV header (16-bit mono PCM) ======
+  const uint32_t data_size = count * SAMPLES_PER_FRAME * 2;
+  audio_file.write("RIFF", 4);
+  write_u32(audio_file, 36 + data_size);
+  audio_file.write("WAVEfmt ", 8);
+  write_u32(audio_file, 16);
+  write_u16(audio_file, 1); // PCM
+  write_u16(audio_file, 1); // mono
+  write_u32(audio_file, SAMPLE_RATE);
+  write_u32(audio_file, SAMPLE_RATE * 2);
+  write_u16(audio_file, 2);
+  write_u16(audio_file, 16);
+  audio_file.write("data", 4);
+  write_u32(audio_file, data_size);
+
+  // ====== Frames ======
+  FrameWriter writer(video_file, FrameFormat::Y4M, width, height, FPS, scale);
+
+  std::vector<uint8_t> frame = base_frame;
+  std::vector<uint8_t> video(width * height);
+  std::vector<int16_t> samples(SAMPLES_PER_FRAME);
+
+  constexpr int16_t AMPLITUDE = 6000;
+  constexpr unsigned int HALF_PERIOD = SAMPLE_RATE / 440 / 2;
+
+  bool sound = base_sound;
+  uint64_t sample_index = 0;
+
+  const size_t tail = (head + slots.size() - count) % slots.size();
+
+  for (size_t n = 0; n < count; n += 1) {
+    const Slot &slot = slots[(tail + n) % slots.size()];
+
+    apply(slot.delta, frame.data());
+    unpack(frame.data(), video.data());
+    writer.WriteFrame(video.data());
+
+    size_t e = 0;
+    for (unsigned int i = 0; i < SAMPLES_PER_FRAME; i += 1, sample_index += 1) {
+      while (e < slot.events.size() && slot.events[e].offset <= i) {
+        sound = slot.events[e].on;
+        e += 1;
+      }
+
+      if (!sound)
+        samples[i] = 0;
+      else
+        samples[i] =
+            (sample_index / HALF_PERIOD) % 2 ? -AMPLITUDE : AMPLITUDE;
+    }
+
+    audio_file.write(reinterpret_cast<const char *>(samples.data()),
+                     samples.size() * sizeof(int16_t));
+  }
+
+  if (!audio_file) {
+    throw std::runtime_error("failed to write data to file: " + basename +
+                             ".wav");
+  }
+
+  return count;
+}
@@ -0,0 +1,104 @@
+// ch8fontgen: build time tool, rasterizes a TTF into a glyph atlas and writes
+// it out as C++ arrays (see include/assets/font.hpp), so ch8emu neither reads
+// nor rasterizes the font at startup.
+//
+// usage: ch8fontgen <font.ttf> <size> <output.cpp>
+//
+// Only uses raylib's CPU side font functions, no window or GL context needed.
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "raylib.h"
+
+constexpr int GLYPH_PADDING = 4; // same as LoadFontEx
+
+int main(int argc, char *argv[]) {
+  if (argc != 4) {
+    std::cerr << "usage: ch8fontgen <font.ttf> <size> <output.cpp>\n";
+    return EXIT_FAILURE;
+  }
+
+  const std::string font_path = argv[1];
+  const int size = std::stoi(argv[2]);
+  const std::string output_path = argv[3];
+
+  int data_size = 0;
+  unsigned char *data = LoadFileData(font_path.c_str(), &data_size);
+  if (data == nullptr) {
+    std::cerr << "error: failed to read font file: " << font_path << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // default ASCII set (32..126), same as LoadFontEx(path, size, 0, 0)
+  const int glyph_count = 95;
+  GlyphInfo *glyphs =
+      LoadFontData(data, data_size, size, nullptr, glyph_count, FONT_DEFAULT);
+  UnloadFileData(data);
+
+  if (glyphs == nullptr) {
+    std::cerr << "error: failed to rasterize font: " << font_path << "\n";
+    return EXIT_FAILURE;
+  }
+
+  Rectangle *recs = nullptr;
+  Image atlas =
+      GenImageFontAtlas(glyphs, &recs, glyph_count, size, GLYPH_PADDING, 0);
+
+  if (atlas.format != PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA) {
+    std::cerr << "error: unexpected atlas pixel format\n";
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream out(output_path);
+  if (!out) {
+    std::cerr << "error: failed to open output file: " << output_path << "\n";
+    return EXIT_FAILURE;
+  }
+
+  out << "// generated by ch8fontgen from " << font_path << ", do not edit\n";
+  out << "#include \"assets/font.hpp\"\n\n";
+  out << "namespace EmbeddedFont {\n\n";
+  out << "const int BASE_SIZE = " << size << ";\n";
+  out << "const int GLYPH_PADDING = " << GLYPH_PADDING << ";\n";
+  out << "const int GLYPH_COUNT = " << glyph_count << ";\n\n";
+
+  out << "const Glyph GLYPHS[] = {\n";
+  for (int i = 0; i < glyph_count; i += 1) {
+    const GlyphInfo &g = glyphs[i];
+    const Rectangle &r = recs[i];
+    out << "    {" << g.value << ", " << g.offsetX << ", " << g.offsetY << ", "
+        << g.advanceX << ", " << r.x << ", " << r.y << ", " << r.width << ", "
+        << r.height << "},\n";
+  }
+  out << "};\n\n";
+
+  out << "const int ATLAS_WIDTH = " << atlas.width << ";\n";
+  out << "const int ATLAS_HEIGHT = " << atlas.height << ";\n\n";
+
+  // gray is always 255, keep the alpha channel only
+  const unsigned char *pixels = static_cast<unsigned char *>(atlas.data);
+  const int pixel_count = atlas.width * atlas.height;
+
+  out << "const uint8_t ATLAS_ALPHA[] = {";
+  for (int i = 0; i < pixel_count; i += 1) {
+    if (i % 24 == 0)
+      out << "\n   ";
+    out << " " << static_cast<int>(pixels[i * 2 + 1]) << ",";
+  }
+  out << "\n};\n\n";
+  out << "} // namespace EmbeddedFont\n";
+
+  UnloadImage(atlas);
+  UnloadFontData(glyphs, glyph_count);
+  std::free(recs);
+
+  if (!out) {
+    std::cerr << "error: failed to write output file: " << output_path << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}